@@ -0,0 +1,381 @@
+/**********************************************************************************
+*  MIT License                                                                    *
+*                                                                                 *
+*  Copyright (c) 2023 Vahan Aghajanyan <vahancho@gmail.com>                       *
+*                                                                                 *
+*  Permission is hereby granted, free of charge, to any person obtaining a copy   *
+*  of this software and associated documentation files (the "Software"), to deal  *
+*  in the Software without restriction, including without limitation the rights   *
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+*  copies of the Software, and to permit persons to whom the Software is          *
+*  furnished to do so, subject to the following conditions:                       *
+*                                                                                 *
+*  The above copyright notice and this permission notice shall be included in all *
+*  copies or substantial portions of the Software.                                *
+*                                                                                 *
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+*  SOFTWARE.                                                                      *
+***********************************************************************************/
+
+
+#include "compressedgraph.h"
+#include "graphene.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+static const constexpr char usage[] =
+"Usage: batch_roadmap [options]\n"
+"Loads the road network once and answers the shortest path queries in parallel\n\n"
+"Each query is a line with the source and target node ids: 'from to'. The results\n"
+"are written as soon as they are found, the latency percentiles are printed to stderr.\n\n"
+"    --input file    read the queries from the file instead of stdin\n"
+"    --socket path   serve the queries of the clients of the Unix domain socket\n"
+"    --threads n     the number of worker threads (all hardware threads by default)\n"
+"    --json          write the results as JSON lines instead of CSV\n";
+
+// The distances are stored with the micro unit precision.
+static constexpr double scale = 1e6;
+
+using Graph = CompressedGraph<int, uint32_t>;
+
+struct Query
+{
+    size_t id;
+    int from;
+    int to;
+};
+
+//! Runs the queries of a stream across the worker threads.
+class Batch
+{
+public:
+    Batch(const Graph &graph, size_t threads, bool json)
+        :
+            m_graph(graph),
+            m_threads(threads),
+            m_json(json)
+    {}
+
+    /// Answers the queries from the \p input and writes the results to the \p output.
+    /*!
+        \return false if the results couldn't be written, e.g. the reader has gone.
+    */
+    bool run(FILE *input, FILE *output)
+    {
+        m_output = output;
+        m_latencies.clear();
+        m_first = m_last = {};
+        m_done = false;
+        m_failed = false;
+
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < m_threads; ++i) {
+            workers.emplace_back([this]() { work(); });
+        }
+
+        if (!m_json && (std::fputs("id,from,to,distance,nodes,latency_us\n", m_output) < 0 ||
+                        std::fflush(m_output) != 0)) {
+            m_failed = true;
+        }
+
+        char line[256];
+        size_t id = 0;
+        // Stop reading the queries nobody will read the results of.
+        while (!m_failed && std::fgets(line, sizeof(line), input)) {
+            Query query{ id, 0, 0 };
+            if (std::sscanf(line, "%d %d", &query.from, &query.to) != 2) {
+                continue;
+            }
+            // The throughput doesn't count the time of waiting for the first query.
+            if (id++ == 0) {
+                std::lock_guard<std::mutex> lock(m_outputMutex);
+                m_first = m_last = std::chrono::steady_clock::now();
+            }
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            // Don't let the reader get too far ahead of the workers.
+            m_space.wait(lock, [this]() { return m_queries.size() < 4 * m_threads; });
+            m_queries.emplace_back(query);
+            m_ready.notify_one();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_done = true;
+        }
+        m_ready.notify_all();
+
+        for (auto &worker : workers) {
+            worker.join();
+        }
+        // From the first query to the last result.
+        const std::chrono::duration<double> elapsed = m_last - m_first;
+        report(elapsed.count());
+
+        return !m_failed;
+    }
+
+private:
+    void work()
+    {
+        std::vector<double> latencies;
+        char buffer[256];
+
+        while (true) {
+            Query query;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_ready.wait(lock, [this]() { return m_done || !m_queries.empty(); });
+                if (m_queries.empty()) {
+                    break;
+                }
+                query = m_queries.front();
+                m_queries.pop_front();
+            }
+            m_space.notify_one();
+
+            // Drain the queue without answering if the results can't be written.
+            if (m_failed) {
+                continue;
+            }
+
+            const auto start = std::chrono::steady_clock::now();
+            const auto path = m_graph.shortestPath(query.from, query.to);
+            const std::chrono::duration<double, std::micro> latency =
+                std::chrono::steady_clock::now() - start;
+            latencies.emplace_back(latency.count());
+
+            // No path is reported with the negative distance.
+            const auto distance = path.empty() ? -1.0 : m_graph.pathWeight(path);
+
+            const auto length = m_json ?
+                std::snprintf(buffer, sizeof(buffer),
+                              "{\"id\":%zu,\"from\":%d,\"to\":%d,\"distance\":%.6f,"
+                              "\"nodes\":%zu,\"latency_us\":%.1f}\n",
+                              query.id, query.from, query.to, distance, path.size(),
+                              latency.count()) :
+                std::snprintf(buffer, sizeof(buffer), "%zu,%d,%d,%.6f,%zu,%.1f\n",
+                              query.id, query.from, query.to, distance, path.size(),
+                              latency.count());
+
+            std::lock_guard<std::mutex> lock(m_outputMutex);
+            // The output streams are fully buffered on pipes and sockets, but
+            // the clients wait for the result of each query.
+            if (!m_failed &&
+                (std::fwrite(buffer, 1, length, m_output) != static_cast<size_t>(length) ||
+                 std::fflush(m_output) != 0)) {
+                m_failed = true;
+            }
+            m_last = std::chrono::steady_clock::now();
+        }
+
+        std::lock_guard<std::mutex> lock(m_outputMutex);
+        m_latencies.insert(m_latencies.end(), latencies.cbegin(), latencies.cend());
+    }
+
+    void report(double seconds)
+    {
+        if (m_latencies.empty()) {
+            std::cerr << "No queries\n";
+            return;
+        }
+
+        std::sort(m_latencies.begin(), m_latencies.end());
+        auto percentile = [this](double p) {
+            return m_latencies[static_cast<size_t>(p * (m_latencies.size() - 1))];
+        };
+
+        std::fprintf(stderr, "%zu queries in %.3f s (%.1f queries/s)\n", m_latencies.size(),
+                     seconds, m_latencies.size() / seconds);
+        std::fprintf(stderr, "latency us: p50 %.1f, p90 %.1f, p99 %.1f, max %.1f\n",
+                     percentile(0.5), percentile(0.9), percentile(0.99), m_latencies.back());
+    }
+
+    const Graph &m_graph;
+    size_t m_threads;
+    bool m_json;
+
+    FILE *m_output{};
+
+    std::mutex m_mutex;
+    std::condition_variable m_ready;
+    std::condition_variable m_space;
+    std::deque<Query> m_queries;
+    bool m_done{};
+
+    std::mutex m_outputMutex;
+    std::vector<double> m_latencies;
+    std::chrono::steady_clock::time_point m_first;
+    std::chrono::steady_clock::time_point m_last;
+    std::atomic<bool> m_failed{};
+};
+
+#if defined(__unix__) || defined(__APPLE__)
+/// Serves the clients of the Unix domain socket one by one.
+static int serve(const std::string &path, Batch &batch)
+{
+    // A client that disconnects early must not kill the server with SIGPIPE,
+    // the failed writes are reported instead.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "The socket path is too long\n";
+        return 1;
+    }
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, path.c_str());
+
+    const auto server = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path.c_str());
+    if (server < 0 || bind(server, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 ||
+        listen(server, 4) < 0) {
+        std::cerr << "Failed to listen on " << path << std::endl;
+        return 1;
+    }
+
+    while (true) {
+        const auto client = accept(server, nullptr, nullptr);
+        if (client < 0) {
+            continue;
+        }
+
+        // Separate streams for reading and writing the same connection.
+        auto input = fdopen(client, "r");
+        auto output = fdopen(dup(client), "w");
+        if (input && output && !batch.run(input, output)) {
+            std::cerr << "Failed to write the results, the client has disconnected\n";
+        }
+
+        if (output) {
+            std::fclose(output);
+        }
+        if (input) {
+            std::fclose(input);
+        } else {
+            close(client);
+        }
+    }
+}
+#endif
+
+int main(int argc, char **argv)
+{
+    std::string inputFile;
+    std::string socketPath;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    bool json = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string option = argv[i];
+        if (option == "--json") {
+            json = true;
+        } else if (option == "--input" && i + 1 < argc) {
+            inputFile = argv[++i];
+        } else if (option == "--socket" && i + 1 < argc) {
+            socketPath = argv[++i];
+        } else if (option == "--threads" && i + 1 < argc) {
+            char *end = nullptr;
+            const auto value = std::strtol(argv[++i], &end, 10);
+            if (end == argv[i] || *end != '\0' || value < 1) {
+                std::cerr << "Incorrect number of threads " << argv[i] << "\n";
+                std::cerr << usage;
+                return 1;
+            }
+            threads = static_cast<size_t>(value);
+        } else {
+            std::cerr << "Incorrect argument " << option << "\n";
+            std::cerr << usage;
+            return 1;
+        }
+    }
+
+    const auto binDirPath = std::filesystem::path(argv[0]).parent_path();
+    const auto edgesFile = binDirPath / "data/edges.txt";
+
+    std::ifstream fileEdges(edgesFile);
+    if (!fileEdges) {
+        std::cerr << "Failed to open file" << edgesFile << std::endl;
+        return 1;
+    }
+
+    Graphene<int, GraphType::Undirected> roadmap;
+    std::map<std::pair<int, int>, double> edges;
+
+    int id{}, start{}, end{};
+    double distance{};
+
+    while (fileEdges >> id >> start >> end >> distance) {
+        edges.emplace(std::make_pair(start, end), distance);
+        // This is an undirected graph.
+        edges.emplace(std::make_pair(end, start), distance);
+        roadmap.addEdge(start, end);
+    }
+
+    // The queries run on the compact snapshot of the road network.
+    const Graph graph(roadmap, [&](int x, int y) { return edges[{x, y}]; }, scale);
+    if (!graph) {
+        std::cerr << "The road network is too large for the node index\n";
+        return 1;
+    }
+    std::cerr << "Loaded " << graph.order() << " nodes and " << graph.size() << " edges\n";
+
+    Batch batch(graph, threads, json);
+
+    if (!socketPath.empty()) {
+#if defined(__unix__) || defined(__APPLE__)
+        return serve(socketPath, batch);
+#else
+        std::cerr << "The Unix domain sockets aren't supported\n";
+        return 1;
+#endif
+    }
+
+    FILE *input = stdin;
+    if (!inputFile.empty()) {
+        input = std::fopen(inputFile.c_str(), "r");
+        if (!input) {
+            std::cerr << "Failed to open file " << inputFile << std::endl;
+            return 1;
+        }
+    }
+
+    const auto written = batch.run(input, stdout);
+
+    if (input != stdin) {
+        std::fclose(input);
+    }
+
+    if (!written) {
+        std::cerr << "Failed to write the results\n";
+        return 1;
+    }
+    return 0;
+}
@@ -23,12 +23,12 @@
 ***********************************************************************************/
 
 #include "graphene.h"
-#include "kmlfile.h"
+#include "pathwriter.h"
 
 #include <iostream>
 #include <filesystem>
 #include <fstream>
-#include <sstream>
+#include <map>
 #include <string>
 
 static const constexpr char usage[] =
@@ -86,23 +86,18 @@ int main(int argc, char **argv)
         return edges[{x, y}];
     };
 
-    // Extract all paths that link to the given node
-    auto paths = graph.shortestPaths(1, weight);
-
-    KmlFile kmlFile(outputFile.string());
+    // The file is written by a background thread while the paths are searched.
+    PathWriter kmlFile(outputFile.string(), PathWriter::Format::Kml, true);
     if (!kmlFile) {
         std::cerr << "Failed to open file" << outputFile << std::endl;
         return 1;
     }
 
-    for (auto && path : paths) {
-        kmlFile.addPlacemark(path, [&] (int nodeId) {
-            const auto &point = nodes[nodeId];
-            std::stringstream stream;
-            stream << std::setprecision(15) << point.first << ',' << point.second;
-            return stream.str();
-        });
-    }
+    // Export the paths that link to the given node as soon as they are found.
+    graph.forEachShortestPath(1, weight, [&] (const auto &path) {
+        kmlFile.addPath(path, [&] (int nodeId) { return nodes[nodeId]; });
+        return kmlFile.pathCount() < maxPaths;
+    });
 
     return 0;
 }
@@ -24,23 +24,24 @@
 
 // Dataset: https://data.europa.eu/data/datasets/19a39b3a-2d9e-4805-a5e6-56a5ca3ec8cb?locale=en
 
+#include "geodesy.h"
 #include "graphene.h"
-#include "kmlfile.h"
+#include "pathwriter.h"
+#include "spatialindex.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <iostream>
 #include <filesystem>
 #include <fstream>
+#include <optional>
 #include <regex>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
-#ifndef M_PI
-#define M_PI (3.14159265358979323846)
-#endif
-
 class Node
 {
 public:
@@ -65,35 +66,14 @@ public:
         return equal(m_lon, other.m_lon) && equal(m_lat, other.m_lat);
     }
 
-    /// The distance between two geodetic points (spherical earth model).
-    double distance(const Node &node, double radius = 6371e3)
+    double latitude() const
     {
-        static constexpr const double radiansInDegree = M_PI / 180.0;
-
-        auto toRadians = [] (double degrees) {
-            return degrees * radiansInDegree;
-        };
-
-        const auto phi1 = toRadians(latitude());
-        const auto lambda1 = toRadians(longitude());
-        const auto phi2 = toRadians(node.latitude());
-        const auto lambda2 = toRadians(node.longitude());
-        const auto deltaPhi = phi2 - phi1;
-        const auto deltaLambda = lambda2 - lambda1;
-
-        const auto a = std::sin(deltaPhi / 2.0) * std::sin(deltaPhi / 2.0) +
-            std::cos(phi1) * std::cos(phi2) *
-            std::sin(deltaLambda / 2.0) * std::sin(deltaLambda / 2.0);
-        const auto c = 2.0 * std::atan2(std::sqrt(a), std::sqrt(1.0 - a));
-
-        return radius * c;
+        return m_lat;
     }
 
-    std::string toString() const
+    double longitude() const
     {
-        std::stringstream stream;
-        stream << std::setprecision(15) << m_lon << ',' << m_lat;
-        return stream.str();
+        return m_lon;
     }
 
 private:
@@ -103,16 +83,6 @@ private:
         return (std::abs(p1 - p2) <= 0.000000000001 * std::min(std::abs(p1), std::abs(p2)));
     }
 
-    double latitude() const
-    {
-        return m_lat;
-    }
-
-    double longitude() const
-    {
-        return m_lon;
-    }
-
     double m_lon;
     double m_lat;
 };
@@ -188,65 +158,87 @@ int main(int argc, char **argv)
         }
     }
 
-    std::string fromStreet;
-    std::string toStreet;
-    auto itFrom = streets.cend();
-    auto itTo   = streets.cend();
+    auto coordinates = [] (const Node &node) {
+        return std::make_pair(node.longitude(), node.latitude());
+    };
+
+    // The index to snap arbitrary coordinates to the road network. It needs planar
+    // coordinates, so the nodes are projected around the mean latitude of the map.
+    double meanLatitude = 0.0;
+    graph.forEachNode([&](const Node &node) {
+        meanLatitude += node.latitude();
+    });
+    meanLatitude /= std::max<size_t>(graph.order(), 1);
+
+    const auto scale = std::cos(meanLatitude * 3.14159265358979323846 / 180.0);
+    auto project = [scale] (double lon, double lat) {
+        return std::make_pair(lon * scale, lat);
+    };
+    const SpatialIndex<Node> index(graph, [&] (const Node &node) {
+        return project(node.longitude(), node.latitude());
+    });
+
+    // The precomputed lengths of the roads.
+    const GeoNodes<Node> geoNodes(graph, coordinates);
+    const GeoEdgeWeights<Node> weight(graph, geoNodes);
+
+    std::string input;
+    std::optional<Node> from;
+    std::optional<Node> to;
     bool entryError = false;
 
+    // Accepts either a street name or the "lon lat" coordinates.
     auto prompt = [&] (const std::string &title) {
         if (!entryError) {
             std::cout << title << '\n';
         }
-        std::getline(std::cin, fromStreet);
-        auto it = streets.find(fromStreet);
-        if (it == streets.cend()) {
+        std::getline(std::cin, input);
+
+        std::optional<Node> node;
+        double lon{}, lat{};
+        std::istringstream stream(input);
+        if (stream >> lon >> lat && (stream >> std::ws).eof()) {
+            node = index.nearest(project(lon, lat));
+        } else if (auto it = streets.find(input); it != streets.cend()) {
+            node = it->second.front();
+        }
+
+        entryError = !node;
+        if (entryError) {
             std::cout << "Not found. Try again, please\n";
-            entryError = true;
-        } else {
-            entryError = false;
         }
-        return it;
+        return node;
     };
 
     while (true) {
-        if (itFrom == streets.cend() && (itFrom = prompt("Enter start street")) == streets.cend()) {
+        if (!from && !(from = prompt("Enter start street or coordinates (lon lat)"))) {
             continue;
         }
 
-        if (itTo == streets.cend() && (itTo = prompt("Enter destination street")) == streets.cend()) {
+        if (!to && !(to = prompt("Enter destination street or coordinates (lon lat)"))) {
             continue;
         }
 
         // Shortest path
-        auto weight = [&] (Node x, Node y) {
-            return x.distance(y);
-        };
-        auto sp = graph.shortestPath(itFrom->second.front(),
-                                     itTo->second.front(),
-                                     weight);
+        auto sp = graph.shortestPath(*from, *to, std::cref(weight));
 
         if (!sp.empty()) {
-            // Calculate the route length.
-            double distance{};
-            for (size_t i = 0; i < sp.size() - 1; ++i) {
-                distance += sp[i].distance(sp[i + 1]);
-            }
+            const auto distance = geoNodes.pathLength(sp);
             std::cout << std::setprecision(6) << "The route found. Length " << distance << " m" << std::endl;
         } else {
             std::cout << "Route not found" << std::endl;
         }
 
-        KmlFile kmlFile(outputFile.string());
+        PathWriter kmlFile(outputFile.string(), PathWriter::Format::Kml);
         if (!kmlFile) {
             std::cerr << "Failed to open file" << outputFile << std::endl;
             return 1;
         }
 
-        kmlFile.addPlacemark(sp, [] (Node &&node) { return node.toString(); });
+        kmlFile.addPath(sp, coordinates);
 
-        itFrom = streets.cend();
-        itTo   = streets.cend();
+        from.reset();
+        to.reset();
     }
 
     return 0;
@@ -0,0 +1,437 @@
+/**********************************************************************************
+*  MIT License                                                                    *
+*                                                                                 *
+*  Copyright (c) 2023 Vahan Aghajanyan <vahancho@gmail.com>                       *
+*                                                                                 *
+*  Permission is hereby granted, free of charge, to any person obtaining a copy   *
+*  of this software and associated documentation files (the "Software"), to deal  *
+*  in the Software without restriction, including without limitation the rights   *
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+*  copies of the Software, and to permit persons to whom the Software is          *
+*  furnished to do so, subject to the following conditions:                       *
+*                                                                                 *
+*  The above copyright notice and this permission notice shall be included in all *
+*  copies or substantial portions of the Software.                                *
+*                                                                                 *
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+*  SOFTWARE.                                                                      *
+***********************************************************************************/
+
+
+#ifndef __COMPRESSEDGRAPH_H__
+#define __COMPRESSEDGRAPH_H__
+
+#include "graphindex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+//! Implements a read-only compressed snapshot of a graph with quantized weights.
+/*!
+    The nodes are numbered in ascending order and the neighbours of each node
+    are stored as the varint encoded differences of their (sorted) numbers.
+    The edges' weights are stored as the fixed point numbers: a weight `w` is
+    kept as `round(w * scale)` clamped to the range of the \p Quantized type.
+
+    The neighbours are decoded eight at a time when all their differences fit
+    in one byte, which is the common case for the graphs with local numbering,
+    e.g. road networks.
+
+    The nodes are numbered with the \p Index type. The snapshot stays empty
+    (see operator bool()) if the graph has too many nodes for it, in which case
+    a wider type, e.g. `uint64_t`, should be used.
+
+    The snapshot doesn't follow the changes of the source graph. The queries
+    can run concurrently, each one takes its own reusable workspace.
+*/
+template<typename NodeType, typename Quantized = uint16_t, typename Index = uint32_t>
+class CompressedGraph
+{
+    static_assert(std::is_unsigned_v<Quantized>, "The quantized weights must be unsigned integers");
+    static_assert(std::is_unsigned_v<Index>, "The node numbers must be unsigned integers");
+
+public:
+    using Path = std::vector<NodeType>;
+
+    /// Compresses the \p graph.
+    /*!
+        \param graph The graph
+        \param weightFunction A function that calculates a weight for an edge (between to nodes)
+        \param scale The number of the quantization steps per weight unit
+    */
+    template<typename Graph, typename Func>
+    CompressedGraph(const Graph &graph, Func weightFunction, double scale = 1.0);
+
+    /// Returns false if the graph is too large for the \p Index type.
+    explicit operator bool() const;
+
+    /// Returns the number of vertices.
+    size_t order() const;
+
+    /// Returns the number of edges.
+    size_t size() const;
+
+    /// Returns the quantization scale.
+    double scale() const;
+
+    /// Returns the number of bytes used by the compressed graph.
+    size_t memoryUsage() const;
+
+    /// Returns the shortest path from the node \p from to the node \p to.
+    Path shortestPath(const NodeType &from, const NodeType &to) const;
+
+    /// Returns the weight of the shortest path or infinity if there is no path.
+    double distance(const NodeType &from, const NodeType &to) const;
+
+    /// Returns the weight of the \p path or infinity if it isn't a path of the graph.
+    double pathWeight(const Path &path) const;
+
+private:
+    static constexpr Index npos = NodeIndex<NodeType, Index>::npos;
+
+    /// Appends the \p value as a varint.
+    void encode(uint64_t value);
+
+    /// Decodes the neighbours of the node \p x into the \p heads.
+    void decode(Index x, std::vector<Index> &heads) const;
+
+    static constexpr uint64_t infinity = std::numeric_limits<uint64_t>::max();
+
+    /// The query state of a reached node.
+    struct Label
+    {
+        uint64_t weight{ infinity };
+        Index previous{ npos };
+        bool settled{ false };
+    };
+
+    using Pair = std::pair<uint64_t, Index>;
+
+    /// The state of a query, reused between the queries.
+    struct Workspace
+    {
+        explicit Workspace(size_t size);
+
+        NodeLabels<Label> labels;
+        std::vector<Pair> queue;
+        std::vector<Index> heads;
+    };
+
+    /// Takes a workspace for a new query.
+    std::unique_ptr<Workspace> acquireWorkspace() const;
+
+    /// Runs Dijkstra and returns the weight of the path found (in quantization steps).
+    /*!
+        The labels of the \p workspace keep the previous nodes of the path.
+    */
+    uint64_t search(Index source, Index target, Workspace &workspace) const;
+
+    NodeIndex<NodeType, Index> m_nodes;
+
+    /// The encoded neighbours of each node.
+    std::vector<size_t> m_byteOffsets;
+    std::vector<uint8_t> m_bytes;
+
+    /// The weights of the edges of each node.
+    std::vector<size_t> m_edgeOffsets;
+    std::vector<Quantized> m_weights;
+
+    double m_scale;
+    bool m_valid;
+
+    /// The query workspaces, one per concurrent query.
+    mutable Pool<Workspace> m_workspaces;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Definition of the function templates
+template<typename NodeType, typename Quantized, typename Index>
+template<typename Graph, typename Func>
+CompressedGraph<NodeType, Quantized, Index>::CompressedGraph(const Graph &graph, Func weight,
+                                                      double scale)
+    :
+        m_scale(scale),
+        // The largest number is reserved for npos.
+        m_valid(graph.order() < size_t{ npos })
+{
+    if (m_valid) {
+        m_nodes = NodeIndex<NodeType, Index>(graph);
+    }
+
+    m_byteOffsets.assign(m_nodes.size() + 1, 0);
+    m_edgeOffsets.assign(m_nodes.size() + 1, 0);
+
+    // The edges come in the ascending order of tiles and heads,
+    // so the differences of the heads' indices are positive.
+    // The differences are calculated in 64 bits, so that they don't overflow for any Index.
+    uint64_t tile = npos;
+    uint64_t last = 0;
+    graph.forEachEdge([&](const NodeType &x, const NodeType &y) {
+        if (!m_valid) {
+            return;
+        }
+
+        const uint64_t head = m_nodes.index(y);
+
+        if (tile == npos || m_nodes.node(static_cast<Index>(tile)) < x) {
+            // Close the nodes up to the new tile.
+            const uint64_t end = m_nodes.index(x);
+            for (auto i = tile == npos ? 0 : tile + 1; i <= end; ++i) {
+                m_byteOffsets[i] = m_bytes.size();
+                m_edgeOffsets[i] = m_weights.size();
+            }
+            tile = end;
+            // The first neighbour is encoded relative to the tile (zigzag).
+            encode(head >= tile ? (head - tile) << 1 : ((tile - head) << 1) - 1);
+        } else {
+            encode(head - last);
+        }
+        last = head;
+
+        const auto w = std::round(weight(x, y) * m_scale);
+        m_weights.emplace_back(static_cast<Quantized>(std::clamp<double>(
+            w, 0.0, std::numeric_limits<Quantized>::max())));
+    });
+
+    for (auto i = tile == npos ? 0 : tile + 1; i <= m_nodes.size(); ++i) {
+        m_byteOffsets[i] = m_bytes.size();
+        m_edgeOffsets[i] = m_weights.size();
+    }
+
+    // The padding to let the decoder read eight bytes at a time.
+    m_bytes.resize(m_bytes.size() + sizeof(uint64_t), 0);
+    m_bytes.shrink_to_fit();
+    m_weights.shrink_to_fit();
+}
+
+template<typename NodeType, typename Quantized, typename Index>
+CompressedGraph<NodeType, Quantized, Index>::operator bool() const
+{
+    return m_valid;
+}
+
+template<typename NodeType, typename Quantized, typename Index>
+size_t CompressedGraph<NodeType, Quantized, Index>::order() const
+{
+    return m_nodes.size();
+}
+
+template<typename NodeType, typename Quantized, typename Index>
+size_t CompressedGraph<NodeType, Quantized, Index>::size() const
+{
+    return m_weights.size();
+}
+
+template<typename NodeType, typename Quantized, typename Index>
+double CompressedGraph<NodeType, Quantized, Index>::scale() const
+{
+    return m_scale;
+}
+
+template<typename NodeType, typename Quantized, typename Index>
+size_t CompressedGraph<NodeType, Quantized, Index>::memoryUsage() const
+{
+    return sizeof(*this) +
+           m_nodes.memoryUsage() +
+           (m_byteOffsets.capacity() + m_edgeOffsets.capacity()) * sizeof(size_t) +
+           m_bytes.capacity() +
+           m_weights.capacity() * sizeof(Quantized);
+}
+
+template<typename NodeType, typename Quantized, typename Index>
+typename CompressedGraph<NodeType, Quantized, Index>::Path
+CompressedGraph<NodeType, Quantized, Index>::shortestPath(const NodeType &from, const NodeType &to) const
+{
+    const auto source = m_nodes.index(from);
+    const auto target = m_nodes.index(to);
+    if (source == npos || target == npos) {
+        return {};
+    }
+
+    auto workspace = acquireWorkspace();
+
+    Path path;
+    if (search(source, target, *workspace) != infinity) {
+        for (auto x = target; x != npos; x = workspace->labels[x].previous) {
+            path.emplace_back(m_nodes.node(x));
+        }
+        std::reverse(path.begin(), path.end());
+    }
+
+    m_workspaces.release(std::move(workspace));
+    return path;
+}
+
+template<typename NodeType, typename Quantized, typename Index>
+double CompressedGraph<NodeType, Quantized, Index>::distance(const NodeType &from, const NodeType &to) const
+{
+    const auto source = m_nodes.index(from);
+    const auto target = m_nodes.index(to);
+    if (source == npos || target == npos) {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    auto workspace = acquireWorkspace();
+    const auto weight = search(source, target, *workspace);
+    m_workspaces.release(std::move(workspace));
+
+    return weight == infinity ? std::numeric_limits<double>::infinity() : weight / m_scale;
+}
+
+template<typename NodeType, typename Quantized, typename Index>
+double CompressedGraph<NodeType, Quantized, Index>::pathWeight(const Path &path) const
+{
+    uint64_t weight = 0;
+    std::vector<Index> heads;
+
+    for (size_t i = 1; i < path.size(); ++i) {
+        const auto x = m_nodes.index(path[i - 1]);
+        const auto y = m_nodes.index(path[i]);
+        if (x == npos || y == npos) {
+            return std::numeric_limits<double>::infinity();
+        }
+
+        decode(x, heads);
+        auto it = std::lower_bound(heads.cbegin(), heads.cend(), y);
+        if (it == heads.cend() || *it != y) {
+            return std::numeric_limits<double>::infinity();
+        }
+        weight += m_weights[m_edgeOffsets[x] + (it - heads.cbegin())];
+    }
+
+    return weight / m_scale;
+}
+
+template<typename NodeType, typename Quantized, typename Index>
+void CompressedGraph<NodeType, Quantized, Index>::encode(uint64_t value)
+{
+    while (value >= 0x80) {
+        m_bytes.emplace_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    m_bytes.emplace_back(static_cast<uint8_t>(value));
+}
+
+template<typename NodeType, typename Quantized, typename Index>
+void CompressedGraph<NodeType, Quantized, Index>::decode(Index x, std::vector<Index> &heads) const
+{
+    const auto count = m_edgeOffsets[x + 1] - m_edgeOffsets[x];
+    heads.resize(count);
+    if (count == 0) {
+        return;
+    }
+
+    auto data = m_bytes.data() + m_byteOffsets[x];
+
+    auto next = [&data]() {
+        uint64_t value = 0;
+        for (int shift = 0;; shift += 7) {
+            const auto byte = *data++;
+            value |= uint64_t(byte & 0x7f) << shift;
+            if (byte < 0x80) {
+                return value;
+            }
+        }
+    };
+
+    const auto first = next();
+    auto head = static_cast<Index>(first & 1 ? x - ((first + 1) >> 1) : x + (first >> 1));
+    heads[0] = head;
+
+    size_t i = 1;
+    while (i < count) {
+        // Eight single byte differences at once.
+        uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        if (i + 8 <= count && (word & 0x8080808080808080ull) == 0) {
+            for (int j = 0; j < 8; ++j) {
+                head += static_cast<Index>(data[j]);
+                heads[i + j] = head;
+            }
+            data += 8;
+            i += 8;
+        } else {
+            head += static_cast<Index>(next());
+            heads[i++] = head;
+        }
+    }
+}
+
+template<typename NodeType, typename Quantized, typename Index>
+CompressedGraph<NodeType, Quantized, Index>::Workspace::Workspace(size_t size)
+    :
+        labels(size)
+{}
+
+template<typename NodeType, typename Quantized, typename Index>
+std::unique_ptr<typename CompressedGraph<NodeType, Quantized, Index>::Workspace>
+CompressedGraph<NodeType, Quantized, Index>::acquireWorkspace() const
+{
+    auto workspace = m_workspaces.acquire(m_nodes.size());
+    workspace->labels.reset();
+    workspace->queue.clear();
+    return workspace;
+}
+
+template<typename NodeType, typename Quantized, typename Index>
+uint64_t CompressedGraph<NodeType, Quantized, Index>::search(Index source, Index target,
+                                                      Workspace &workspace) const
+{
+    // Only the labels of the reached nodes are reset, so the cost of a query
+    // depends on the nodes it reaches rather than on the size of the graph.
+    auto &labels = workspace.labels;
+    auto &queue = workspace.queue;
+    auto &heads = workspace.heads;
+    const std::greater<Pair> greater;
+
+    labels[source].weight = 0;
+    queue.push_back({ 0, source });
+
+    while (!queue.empty()) {
+        std::pop_heap(queue.begin(), queue.end(), greater);
+        const auto [weight, x] = queue.back();
+        queue.pop_back();
+
+        auto &label = labels[x];
+        if (label.settled) {
+            continue;
+        }
+        label.settled = true;
+
+        if (x == target) {
+            return weight;
+        }
+
+        decode(x, heads);
+        const auto edgeWeights = m_weights.data() + m_edgeOffsets[x];
+
+        for (size_t i = 0; i < heads.size(); ++i) {
+            const auto y = heads[i];
+            const auto total = weight + edgeWeights[i];
+            auto &adjacent = labels[y];
+            if (!adjacent.settled && total < adjacent.weight) {
+                adjacent.weight = total;
+                adjacent.previous = x;
+                queue.push_back({ total, y });
+                std::push_heap(queue.begin(), queue.end(), greater);
+            }
+        }
+    }
+
+    return infinity;
+}
+
+#endif // !__COMPRESSEDGRAPH_H__
@@ -0,0 +1,613 @@
+/**********************************************************************************
+*  MIT License                                                                    *
+*                                                                                 *
+*  Copyright (c) 2023 Vahan Aghajanyan <vahancho@gmail.com>                       *
+*                                                                                 *
+*  Permission is hereby granted, free of charge, to any person obtaining a copy   *
+*  of this software and associated documentation files (the "Software"), to deal  *
+*  in the Software without restriction, including without limitation the rights   *
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+*  copies of the Software, and to permit persons to whom the Software is          *
+*  furnished to do so, subject to the following conditions:                       *
+*                                                                                 *
+*  The above copyright notice and this permission notice shall be included in all *
+*  copies or substantial portions of the Software.                                *
+*                                                                                 *
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+*  SOFTWARE.                                                                      *
+***********************************************************************************/
+
+
+#ifndef __GEODESY_H__
+#define __GEODESY_H__
+
+#include "graphindex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+// The SIMD instructions used by the haversine kernel.
+#if defined(__AVX__)
+#define GEODESY_AVX
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GEODESY_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define GEODESY_NEON
+#include <arm_neon.h>
+#endif
+
+//! Implements the geodetic distances between the graph nodes.
+/*!
+    The nodes' coordinates are converted to radians and stored together with
+    the latitude cosines in separate arrays (structure of arrays), so that the
+    haversine formula needs no conversions and only two sines, a square root
+    and an arc sine per distance. The distances are calculated in batches by
+    a kernel that evaluates the sines and the arc sine with polynomials on
+    the AVX, SSE2 or NEON registers, whichever is available at compile time,
+    and one distance at a time otherwise. The polynomials are accurate to
+    about one ulp, and the same ones are used for the leftover distances, so
+    the results don't depend on a node's position in a batch.
+
+    The distances are calculated on a spherical earth model.
+*/
+template<typename NodeType>
+class GeoNodes
+{
+public:
+    /// Creates the coordinates table for all nodes of the \p graph.
+    /*!
+        \param graph The graph
+        \param coordinates A function that returns the (lon, lat) coordinates of a node in degrees
+        \param radius The earth radius
+    */
+    template<typename Graph, typename Accessor>
+    GeoNodes(const Graph &graph, Accessor coordinates, double radius = 6371e3);
+
+    /// Returns the number of nodes.
+    size_t size() const;
+
+    /// Returns the index of the \p node or size() if there is no such node.
+    size_t index(const NodeType &node) const;
+
+    /// Returns the node with the given \p index.
+    const NodeType &node(size_t index) const;
+
+    /// Returns the distance between two nodes or infinity if any of them is unknown.
+    double distance(const NodeType &from, const NodeType &to) const;
+
+    /// Calculates the distances from the node \p from to \p count nodes \p to.
+    /*!
+        \param from The source node's index
+        \param to The target nodes' indexes
+        \param count The number of the target nodes
+        \param result The output array of \p count distances
+    */
+    void distances(size_t from, const size_t *to, size_t count, double *result) const;
+
+    /// Returns the length of the \p path or infinity if any of the nodes is unknown.
+    template<typename Container>
+    double pathLength(const Container &path) const;
+
+private:
+    struct ScalarLanes;
+    struct VectorLanes;
+
+    /// The haversine formula over the arrays of the coordinates' deltas.
+    void haversine(const double *deltaLat, const double *deltaLon, const double *cosProduct,
+                   size_t count, double *result) const;
+
+    /// The haversine formula for each lane.
+    template<typename Lanes>
+    static Lanes haversine(Lanes deltaLat, Lanes deltaLon, Lanes cosProduct, Lanes diameter);
+
+    /// Returns the squared sine of \p x in [-pi, pi].
+    template<typename Lanes>
+    static Lanes sinSquared(Lanes x);
+
+    /// Returns the arc sine of \p x in [0, 1].
+    template<typename Lanes>
+    static Lanes arcSin(Lanes x);
+
+    /// Evaluates the polynomial with the given \p coefficients, the highest power first.
+    template<typename Lanes, size_t N>
+    static Lanes polynomial(Lanes x, const double (&coefficients)[N]);
+
+    /// The size of the batches processed by the haversine kernel.
+    static constexpr size_t batchSize = 64;
+
+    double m_radius;
+
+    /// The nodes and their coordinates.
+    NodeIndex<NodeType> m_nodes;
+    std::vector<double> m_lon;
+    std::vector<double> m_lat;
+    std::vector<double> m_cosLat;
+};
+
+//! Implements the precomputed geodetic lengths of the graph edges.
+/*!
+    The object is a weight function for the Graphene's searches. The searches
+    take the lengths of a node's edges with tile(), in constant time per edge.
+*/
+template<typename NodeType>
+class GeoEdgeWeights
+{
+public:
+    /// Calculates the lengths of all edges of the \p graph.
+    /*!
+        The \p nodes must be created for the same graph and outlive the object.
+    */
+    template<typename Graph>
+    GeoEdgeWeights(const Graph &graph, const GeoNodes<NodeType> &nodes);
+
+    /// Returns the number of edges.
+    size_t size() const;
+
+    /// Returns the length of the edge (\p tile, \p head) or infinity if there is no such edge.
+    double operator()(const NodeType &tile, const NodeType &head) const;
+
+    class Tile;
+
+    /// Returns the lengths of the edges of the \p node as a function of their heads.
+    /*!
+        The \p index is the node's number in the GeoNodes if it's known, e.g. from
+        the Tile::index() of an edge to the node, or npos. The result is valid as
+        long as the object.
+    */
+    Tile tile(const NodeType &node, size_t index = npos) const;
+
+private:
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+    const GeoNodes<NodeType> &m_nodes;
+    EdgeIndex<> m_edges;
+
+    /// The lengths of the edges.
+    std::vector<double> m_weights;
+};
+
+//! Implements the lengths of the edges of one node as a function of their heads.
+/*!
+    The edges are looked up with an EdgeCursor, so the heads in ascending order
+    take constant time each.
+*/
+template<typename NodeType>
+class GeoEdgeWeights<NodeType>::Tile
+{
+public:
+    Tile(const GeoEdgeWeights &weights, size_t tile);
+
+    /// Returns the length of the edge to the \p head or infinity if there is no such edge.
+    double operator()(const NodeType &head);
+
+    /// Returns the number of the last edge's head or npos if there was no such edge.
+    size_t index() const;
+
+private:
+    const GeoEdgeWeights *m_weights;
+    EdgeCursor<GeoNodes<NodeType>> m_cursor;
+    size_t m_index{ npos };
+};
+
+//! A single double with the interface of the SIMD lanes.
+template<typename NodeType>
+struct GeoNodes<NodeType>::ScalarLanes
+{
+    static constexpr size_t width = 1;
+
+    ScalarLanes(double x) : value(x) {}
+
+    static ScalarLanes load(const double *p) { return *p; }
+    void store(double *p) const { *p = value; }
+
+    friend ScalarLanes operator+(ScalarLanes x, ScalarLanes y) { return x.value + y.value; }
+    friend ScalarLanes operator-(ScalarLanes x, ScalarLanes y) { return x.value - y.value; }
+    friend ScalarLanes operator*(ScalarLanes x, ScalarLanes y) { return x.value * y.value; }
+    friend ScalarLanes operator/(ScalarLanes x, ScalarLanes y) { return x.value / y.value; }
+
+    static ScalarLanes sqrt(ScalarLanes x) { return std::sqrt(x.value); }
+    static ScalarLanes min(ScalarLanes x, ScalarLanes y) { return std::min(x.value, y.value); }
+
+    /// Returns \p a where \p x > \p y and \p b elsewhere.
+    static ScalarLanes select(ScalarLanes x, ScalarLanes y, ScalarLanes a, ScalarLanes b)
+    {
+        return x.value > y.value ? a : b;
+    }
+
+    double value;
+};
+
+#if defined(GEODESY_AVX)
+//! Four doubles in an AVX register.
+template<typename NodeType>
+struct GeoNodes<NodeType>::VectorLanes
+{
+    static constexpr size_t width = 4;
+
+    VectorLanes(__m256d x) : value(x) {}
+    VectorLanes(double x) : value(_mm256_set1_pd(x)) {}
+
+    static VectorLanes load(const double *p) { return _mm256_loadu_pd(p); }
+    void store(double *p) const { _mm256_storeu_pd(p, value); }
+
+    friend VectorLanes operator+(VectorLanes x, VectorLanes y) { return _mm256_add_pd(x.value, y.value); }
+    friend VectorLanes operator-(VectorLanes x, VectorLanes y) { return _mm256_sub_pd(x.value, y.value); }
+    friend VectorLanes operator*(VectorLanes x, VectorLanes y) { return _mm256_mul_pd(x.value, y.value); }
+    friend VectorLanes operator/(VectorLanes x, VectorLanes y) { return _mm256_div_pd(x.value, y.value); }
+
+    static VectorLanes sqrt(VectorLanes x) { return _mm256_sqrt_pd(x.value); }
+    static VectorLanes min(VectorLanes x, VectorLanes y) { return _mm256_min_pd(x.value, y.value); }
+
+    static VectorLanes select(VectorLanes x, VectorLanes y, VectorLanes a, VectorLanes b)
+    {
+        return _mm256_blendv_pd(b.value, a.value, _mm256_cmp_pd(x.value, y.value, _CMP_GT_OQ));
+    }
+
+    __m256d value;
+};
+#elif defined(GEODESY_SSE2)
+//! Two doubles in an SSE2 register.
+template<typename NodeType>
+struct GeoNodes<NodeType>::VectorLanes
+{
+    static constexpr size_t width = 2;
+
+    VectorLanes(__m128d x) : value(x) {}
+    VectorLanes(double x) : value(_mm_set1_pd(x)) {}
+
+    static VectorLanes load(const double *p) { return _mm_loadu_pd(p); }
+    void store(double *p) const { _mm_storeu_pd(p, value); }
+
+    friend VectorLanes operator+(VectorLanes x, VectorLanes y) { return _mm_add_pd(x.value, y.value); }
+    friend VectorLanes operator-(VectorLanes x, VectorLanes y) { return _mm_sub_pd(x.value, y.value); }
+    friend VectorLanes operator*(VectorLanes x, VectorLanes y) { return _mm_mul_pd(x.value, y.value); }
+    friend VectorLanes operator/(VectorLanes x, VectorLanes y) { return _mm_div_pd(x.value, y.value); }
+
+    static VectorLanes sqrt(VectorLanes x) { return _mm_sqrt_pd(x.value); }
+    static VectorLanes min(VectorLanes x, VectorLanes y) { return _mm_min_pd(x.value, y.value); }
+
+    static VectorLanes select(VectorLanes x, VectorLanes y, VectorLanes a, VectorLanes b)
+    {
+        const auto mask = _mm_cmpgt_pd(x.value, y.value);
+        return _mm_or_pd(_mm_and_pd(mask, a.value), _mm_andnot_pd(mask, b.value));
+    }
+
+    __m128d value;
+};
+#elif defined(GEODESY_NEON)
+//! Two doubles in a NEON register.
+template<typename NodeType>
+struct GeoNodes<NodeType>::VectorLanes
+{
+    static constexpr size_t width = 2;
+
+    VectorLanes(float64x2_t x) : value(x) {}
+    VectorLanes(double x) : value(vdupq_n_f64(x)) {}
+
+    static VectorLanes load(const double *p) { return vld1q_f64(p); }
+    void store(double *p) const { vst1q_f64(p, value); }
+
+    friend VectorLanes operator+(VectorLanes x, VectorLanes y) { return vaddq_f64(x.value, y.value); }
+    friend VectorLanes operator-(VectorLanes x, VectorLanes y) { return vsubq_f64(x.value, y.value); }
+    friend VectorLanes operator*(VectorLanes x, VectorLanes y) { return vmulq_f64(x.value, y.value); }
+    friend VectorLanes operator/(VectorLanes x, VectorLanes y) { return vdivq_f64(x.value, y.value); }
+
+    static VectorLanes sqrt(VectorLanes x) { return vsqrtq_f64(x.value); }
+    static VectorLanes min(VectorLanes x, VectorLanes y) { return vminq_f64(x.value, y.value); }
+
+    static VectorLanes select(VectorLanes x, VectorLanes y, VectorLanes a, VectorLanes b)
+    {
+        return vbslq_f64(vcgtq_f64(x.value, y.value), a.value, b.value);
+    }
+
+    float64x2_t value;
+};
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Definition of the function templates
+template<typename NodeType>
+template<typename Graph, typename Accessor>
+GeoNodes<NodeType>::GeoNodes(const Graph &graph, Accessor coordinates, double radius)
+    :
+        m_radius(radius),
+        m_nodes(graph)
+{
+    static constexpr double radiansInDegree = 3.14159265358979323846 / 180.0;
+
+    m_lon.reserve(size());
+    m_lat.reserve(size());
+    m_cosLat.reserve(size());
+
+    for (size_t i = 0; i < size(); ++i) {
+        const auto [lon, lat] = coordinates(m_nodes.node(i));
+        m_lon.emplace_back(lon * radiansInDegree);
+        m_lat.emplace_back(lat * radiansInDegree);
+        m_cosLat.emplace_back(std::cos(m_lat.back()));
+    }
+}
+
+template<typename NodeType>
+size_t GeoNodes<NodeType>::size() const
+{
+    return m_nodes.size();
+}
+
+template<typename NodeType>
+size_t GeoNodes<NodeType>::index(const NodeType &node) const
+{
+    const auto i = m_nodes.index(node);
+    return i == NodeIndex<NodeType>::npos ? size() : i;
+}
+
+template<typename NodeType>
+const NodeType &GeoNodes<NodeType>::node(size_t index) const
+{
+    return m_nodes.node(index);
+}
+
+template<typename NodeType>
+double GeoNodes<NodeType>::distance(const NodeType &from, const NodeType &to) const
+{
+    const auto i = index(from);
+    const auto j = index(to);
+    if (i == size() || j == size()) {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    double result;
+    distances(i, &j, 1, &result);
+    return result;
+}
+
+template<typename NodeType>
+void GeoNodes<NodeType>::distances(size_t from, const size_t *to, size_t count,
+                                   double *result) const
+{
+    double deltaLat[batchSize];
+    double deltaLon[batchSize];
+    double cosProduct[batchSize];
+
+    for (size_t first = 0; first < count; first += batchSize) {
+        const auto n = std::min(batchSize, count - first);
+
+        // Gather the coordinates, so that the kernel works on contiguous arrays.
+        for (size_t i = 0; i < n; ++i) {
+            const auto j = to[first + i];
+            deltaLat[i] = m_lat[j] - m_lat[from];
+            deltaLon[i] = m_lon[j] - m_lon[from];
+            cosProduct[i] = m_cosLat[j] * m_cosLat[from];
+        }
+
+        haversine(deltaLat, deltaLon, cosProduct, n, result + first);
+    }
+}
+
+template<typename NodeType>
+template<typename Container>
+double GeoNodes<NodeType>::pathLength(const Container &path) const
+{
+    double deltaLat[batchSize];
+    double deltaLon[batchSize];
+    double cosProduct[batchSize];
+    double lengths[batchSize];
+
+    double result{};
+    size_t n{};
+    size_t previous = size();
+
+    for (auto && node : path) {
+        const auto current = index(node);
+        if (current == size()) {
+            return std::numeric_limits<double>::infinity();
+        }
+
+        if (previous != size()) {
+            deltaLat[n] = m_lat[current] - m_lat[previous];
+            deltaLon[n] = m_lon[current] - m_lon[previous];
+            cosProduct[n] = m_cosLat[current] * m_cosLat[previous];
+
+            if (++n == batchSize) {
+                haversine(deltaLat, deltaLon, cosProduct, n, lengths);
+                result = std::accumulate(lengths, lengths + n, result);
+                n = 0;
+            }
+        }
+        previous = current;
+    }
+
+    if (n > 0) {
+        haversine(deltaLat, deltaLon, cosProduct, n, lengths);
+        result = std::accumulate(lengths, lengths + n, result);
+    }
+    return result;
+}
+
+template<typename NodeType>
+void GeoNodes<NodeType>::haversine(const double *deltaLat, const double *deltaLon,
+                                   const double *cosProduct, size_t count,
+                                   double *result) const
+{
+    const auto diameter = 2.0 * m_radius;
+    size_t i = 0;
+
+#if defined(GEODESY_AVX) || defined(GEODESY_SSE2) || defined(GEODESY_NEON)
+    using Lanes = VectorLanes;
+    for (; i + Lanes::width <= count; i += Lanes::width) {
+        haversine<Lanes>(Lanes::load(deltaLat + i), Lanes::load(deltaLon + i),
+                         Lanes::load(cosProduct + i), diameter).store(result + i);
+    }
+#endif
+
+    for (; i < count; ++i) {
+        haversine<ScalarLanes>(deltaLat[i], deltaLon[i], cosProduct[i], diameter)
+            .store(result + i);
+    }
+}
+
+template<typename NodeType>
+template<typename Lanes>
+Lanes GeoNodes<NodeType>::haversine(Lanes deltaLat, Lanes deltaLon, Lanes cosProduct,
+                                    Lanes diameter)
+{
+    // The longitudes' difference is in [-2pi, 2pi], so the halves are in [-pi, pi].
+    const auto a = Lanes::min(1.0, sinSquared(deltaLat * 0.5) +
+                                   cosProduct * sinSquared(deltaLon * 0.5));
+    return diameter * arcSin(Lanes::sqrt(a));
+}
+
+template<typename NodeType>
+template<typename Lanes>
+Lanes GeoNodes<NodeType>::sinSquared(Lanes x)
+{
+    // The Cephes library's sine and cosine polynomials for [-pi/4, pi/4].
+    static constexpr double sinCoefficients[] = {
+        1.58962301576546568060e-10, -2.50507477628578072866e-8, 2.75573136213857245213e-6,
+        -1.98412698295895385996e-4, 8.33333333332211858878e-3, -1.66666666666666307295e-1 };
+    static constexpr double cosCoefficients[] = {
+        -1.13585365213876817300e-11, 2.08757008419747316778e-9, -2.75573141792967388112e-7,
+        2.48015872888517045348e-5, -1.38888888888730564116e-3, 4.16666666666665929218e-2 };
+
+    // Adding and subtracting it rounds to an integer.
+    static constexpr double round = 6755399441055744.0;
+
+    // The nearest multiple of pi/2 and the remainder in [-pi/4, pi/4]
+    // (pi/2 is split in three parts to keep the remainder precise).
+    const auto j = (x * 0.636619772367581343076 + round) - round;
+    const auto r = ((x - j * 1.57079625129699707031) - j * 7.54978941586159635335e-8) -
+                   j * 5.39030285815811905290e-15;
+    const auto z = r * r;
+
+    const auto sine = r + r * z * polynomial(z, sinCoefficients);
+    const auto cosine = Lanes(1.0) - z * 0.5 + z * z * polynomial(z, cosCoefficients);
+
+    // The square is sin^2(r) for the even multiples and cos^2(r) for the odd ones.
+    const auto odd = j - ((j * 0.5 + round) - round) * 2.0;
+    const auto sin2 = sine * sine;
+    return sin2 + odd * odd * (cosine * cosine - sin2);
+}
+
+template<typename NodeType>
+template<typename Lanes>
+Lanes GeoNodes<NodeType>::arcSin(Lanes x)
+{
+    // The Cephes library's rational approximations for [0, 0.625] and (0.625, 1].
+    static constexpr double p[] = {
+        4.253011369004428248960e-3, -6.019598008014123785661e-1, 5.444622390564711410273e0,
+        -1.626247967210700244449e1, 1.956261983317594739197e1, -8.198089802484824371615e0 };
+    static constexpr double q[] = {
+        1.0, -1.474091372988853791896e1, 7.049610280856842141659e1,
+        -1.471791292232726029859e2, 1.395105614657485689735e2, -4.918853881490881290097e1 };
+    static constexpr double r[] = {
+        2.967721961301243206100e-3, -5.634242780008963776856e-1, 6.968710824104713396794e0,
+        -2.556901049652824852289e1, 2.853665548261061424989e1 };
+    static constexpr double s[] = {
+        1.0, -2.194779531642920639778e1, 1.470656354026814941758e2,
+        -3.838770957603691357202e2, 3.424398657913078477438e2 };
+
+    static constexpr double quarterPi = 7.85398163397448309616e-1;
+    static constexpr double quarterPiTail = 6.123233995736765886130e-17;
+
+    const auto x2 = x * x;
+    const auto small = x + x * (x2 * polynomial(x2, p) / polynomial(x2, q));
+
+    // asin(x) = pi/2 - 2 asin(sqrt((1 - x) / 2))
+    const auto w = Lanes(1.0) - x;
+    const auto t = Lanes::sqrt(w + w);
+    const auto large = ((Lanes(quarterPi) - t) - (t * (w * polynomial(w, r) / polynomial(w, s)) -
+                        quarterPiTail)) + quarterPi;
+
+    return Lanes::select(x, 0.625, large, small);
+}
+
+template<typename NodeType>
+template<typename Lanes, size_t N>
+Lanes GeoNodes<NodeType>::polynomial(Lanes x, const double (&coefficients)[N])
+{
+    Lanes result = coefficients[0];
+    for (size_t i = 1; i < N; ++i) {
+        result = result * x + coefficients[i];
+    }
+    return result;
+}
+
+template<typename NodeType>
+template<typename Graph>
+GeoEdgeWeights<NodeType>::GeoEdgeWeights(const Graph &graph, const GeoNodes<NodeType> &nodes)
+    :
+        m_nodes(nodes),
+        m_edges(graph, nodes)
+{
+    m_weights.resize(m_edges.size());
+    for (size_t i = 0; i < m_nodes.size(); ++i) {
+        const auto first = m_edges.begin(i);
+        m_nodes.distances(i, m_edges.heads(i), m_edges.end(i) - first, m_weights.data() + first);
+    }
+}
+
+template<typename NodeType>
+size_t GeoEdgeWeights<NodeType>::size() const
+{
+    return m_weights.size();
+}
+
+template<typename NodeType>
+double GeoEdgeWeights<NodeType>::operator()(const NodeType &tile, const NodeType &head) const
+{
+    const auto i = m_nodes.index(tile);
+    const auto j = m_nodes.index(head);
+
+    if (i != m_nodes.size() && j != m_nodes.size()) {
+        const auto e = m_edges.edge(i, j);
+        if (e != EdgeIndex<>::npos) {
+            return m_weights[e];
+        }
+    }
+
+    return std::numeric_limits<double>::infinity();
+}
+
+template<typename NodeType>
+typename GeoEdgeWeights<NodeType>::Tile
+GeoEdgeWeights<NodeType>::tile(const NodeType &node, size_t index) const
+{
+    return Tile(*this, index == npos ? m_nodes.index(node) : index);
+}
+
+template<typename NodeType>
+GeoEdgeWeights<NodeType>::Tile::Tile(const GeoEdgeWeights &weights, size_t tile)
+    :
+        m_weights(&weights),
+        m_cursor(weights.m_nodes, weights.m_edges, tile)
+{}
+
+template<typename NodeType>
+double GeoEdgeWeights<NodeType>::Tile::operator()(const NodeType &head)
+{
+    const auto e = m_cursor.edge(head);
+    if (e == EdgeIndex<>::npos) {
+        m_index = npos;
+        return std::numeric_limits<double>::infinity();
+    }
+
+    m_index = m_weights->m_edges.head(e);
+    return m_weights->m_weights[e];
+}
+
+template<typename NodeType>
+size_t GeoEdgeWeights<NodeType>::Tile::index() const
+{
+    return m_index;
+}
+
+#endif // !__GEODESY_H__
@@ -25,12 +25,20 @@
 #ifndef __GRAPHENE_H__
 #define __GRAPHENE_H__
 
-#include <any>
+#include "graphindex.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <iomanip>
+#include <limits>
 #include <map>
-#include <optional>
+#include <memory>
+#include <memory_resource>
 #include <set>
-#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 enum class GraphType
 {
@@ -39,12 +47,50 @@ enum class GraphType
 };
 
 //! Implements an abstract graph.
-template<typename NodeType, GraphType GT = GraphType::Directed>
+/*!
+    The \p Allocator is used for the adjacency storage. For example, with
+    `std::pmr::polymorphic_allocator` (see PmrGraphene) the whole graph can be
+    allocated in a `std::pmr::monotonic_buffer_resource` arena or in a pool.
+*/
+template<typename NodeType, GraphType GT = GraphType::Directed,
+         typename Allocator = std::allocator<NodeType>>
 class Graphene
 {
 public:
     using Path  = std::vector<NodeType>;
     using Paths = std::vector<Path>;
+    using Edge  = std::pair<NodeType, NodeType>;
+    using Edges = std::vector<Edge>;
+
+    /// The nearest source node and the weight of the path from it.
+    template<typename WeightType>
+    struct NearestSource
+    {
+        NodeType source;
+        WeightType weight;
+    };
+
+    /// The nearest sources of the nodes.
+    template<typename WeightType>
+    using NearestSources = std::map<NodeType, NearestSource<WeightType>>;
+    using AllocatorType = Allocator;
+
+    /// The estimated memory footprint of a graph in bytes.
+    struct MemoryUsage
+    {
+        /// The adjacency structure: the tree nodes and the neighbours' copies.
+        size_t adjacency{};
+        /// The node payloads (the nodes stored once per node).
+        size_t nodes{};
+
+        size_t total() const { return adjacency + nodes; }
+    };
+
+    /// Creates an empty graph.
+    Graphene() = default;
+
+    /// Creates an empty graph that allocates its storage with the given \p allocator.
+    explicit Graphene(const Allocator &allocator);
 
     /// Adds new node.
     template<typename UR = NodeType>
@@ -60,18 +106,38 @@ public:
     /// The size of a graph is its number of edges
     size_t size() const;
 
+    /// Returns the estimated memory used by the graph.
+    /*!
+        The estimation assumes the typical red-black tree node layout and doesn't
+        include the memory owned by the nodes themselves (e.g. strings) or
+        the allocator's overhead.
+    */
+    MemoryUsage memoryUsage() const;
+
     /// The degree or valency of a vertex is the number of edges that are incident to it
     size_t nodeDegree(const NodeType &node) const;
 
     /// Two nodes \p x and \p y are adjacent if {x, y} is an edge
     bool adjacent(const NodeType &x, const NodeType &y) const;
 
+    /// Calls the \p func for each node of the graph in ascending order.
+    template <typename Func>
+    void forEachNode(Func func) const;
+
+    /// Calls the \p func as `func(tile, head)` for each edge in the ascending order of tiles and heads.
+    /*!
+        The edges of an undirected graph are visited in both directions.
+    */
+    template <typename Func>
+    void forEachEdge(Func func) const;
+
     /// Returns the shortest path from the node \p from to the node \p to.
     /*!
         The function uses the Dijkstra algorithms for the shortest path between
         two nodes. The \p weightFunction is a custom function that returns weight
         that corresponds to two nodes (edge). For example, it can be a distance
-        between two geometrical points.
+        between two geometrical points. The searches copy the weight function,
+        so a table of weights like GeoEdgeWeights is better passed via std::cref().
 
         \param from The source node
         \param to The target node
@@ -81,6 +147,22 @@ public:
     template <typename Func>
     Path shortestPath(const NodeType &from, const NodeType &to, Func weightFunction) const;
 
+    /// Returns the shortest path from the node \p from to the node \p to within the \p maxWeight.
+    /*!
+        The same as shortestPath(), but the search is abandoned as soon as
+        all paths within the \p maxWeight are explored, so that the cost of
+        a query for a remote or unreachable node is bounded.
+
+        \param from The source node
+        \param to The target node
+        \param weightFunction A function that calculates a weight for an edge (between to nodes)
+        \param maxWeight The maximum weight of the path
+        \return A shortest path or an empty path if there is no path within the \p maxWeight.
+    */
+    template <typename Func>
+    Path shortestPath(const NodeType &from, const NodeType &to, Func weightFunction,
+                      std::invoke_result_t<Func, const NodeType &, const NodeType &> maxWeight) const;
+
     /// Returns the shortest paths from the node \p from to all connected nodes.
     /*!
         The function uses the Dijkstra algorithms for the shortest path between
@@ -95,80 +177,443 @@ public:
     template <typename Func>
     Paths shortestPaths(const NodeType &from, Func weightFunction) const;
 
+    /// Returns the shortest paths from the node \p from to all nodes within the \p maxWeight.
+    /*!
+        The same as shortestPaths(), but the search doesn't go beyond the nodes
+        with the total weight greater than \p maxWeight.
+
+        \param from The source node
+        \param weightFunction A function that calculates a weight for an edge (between to nodes)
+        \param maxWeight The maximum weight of the paths
+        \return A shortest paths (list of the lists of nodes).
+    */
+    template <typename Func>
+    Paths shortestPaths(const NodeType &from, Func weightFunction,
+                        std::invoke_result_t<Func, const NodeType &, const NodeType &> maxWeight) const;
+
+    /// Returns the earliest arrival path from the node \p from to the node \p to.
+    /*!
+        The function uses the time-dependent Dijkstra algorithm. The \p travelTimeFunction
+        returns the travel time along an edge for the given departure time from the
+        edge's tile, for example TravelTimeProfiles. The travel times must have the
+        FIFO property (departing later never means arriving earlier), so that a single
+        search pass finds the earliest arrival. Infinite travel times mean that an
+        edge can't be traversed. The function is taken by value, so a large
+        function object like TravelTimeProfiles should be wrapped with std::cref().
+
+        \param from The source node
+        \param to The target node
+        \param departureTime The departure time from the source node
+        \param travelTimeFunction A function that is called as `travelTimeFunction(tile, head, time)`
+        \return The path (list of nodes) with the earliest arrival to the target node.
+    */
+    template <typename TimeType, typename Func>
+    Path earliestArrivalPath(const NodeType &from, const NodeType &to, TimeType departureTime,
+                             Func travelTimeFunction) const;
+
+    /// Calls the \p visitor with the shortest path to each node connected to the node \p from.
+    /*!
+        Unlike shortestPaths() the paths are not collected: the \p visitor receives
+        each path as soon as it becomes final, i.e. in the order of the paths'
+        weights. The path is only valid during the call. If the visitor returns
+        false the search stops.
+
+        \param from The source node
+        \param weightFunction A function that calculates a weight for an edge (between to nodes)
+        \param visitor A function that is called as `visitor(const Path &path)`
+    */
+    template <typename Func, typename Visitor>
+    void forEachShortestPath(const NodeType &from, Func weightFunction, Visitor visitor) const;
+
+    /// Calls the \p visitor for each node connected to the node \p from as soon as the node is settled.
+    /*!
+        A node is settled when the weight of the shortest path to it becomes final.
+        The nodes are settled in the order of their weights. If the visitor returns
+        false the search stops.
+
+        \param from The source node
+        \param weightFunction A function that calculates a weight for an edge (between to nodes)
+        \param visitor A function that is called as `visitor(node, previous, weight)`, where
+                       `previous` is the previous node on the shortest path (the node itself
+                       for the source node) and `weight` is the total weight of the path.
+    */
+    template <typename Func, typename Visitor>
+    void forEachSettledNode(const NodeType &from, Func weightFunction, Visitor visitor) const;
+
+    /// Returns up to \p k shortest loopless paths from the node \p from to the node \p to.
+    /*!
+        The function uses the Yen's algorithm. The first path is the one that
+        shortestPath() returns, every next path is the cheapest deviation from
+        the already found ones. The spur paths are searched on the same graph
+        with the deviating edges and the root path nodes masked out, so that the
+        graph is never copied.
+
+        The weights of all edges are taken once before the searches, so the
+        \p weightFunction doesn't need to be thread safe. The spur searches of
+        each path run in parallel.
+
+        \param from The source node
+        \param to The target node
+        \param k The maximum number of paths to return
+        \param weightFunction A function that calculates a weight for an edge (between to nodes)
+        \param threads The number of threads, or 0 to use all hardware threads
+        \return Up to k shortest paths ordered by their total weight.
+    */
+    template <typename Func>
+    Paths kShortestPaths(const NodeType &from, const NodeType &to, size_t k,
+                         Func weightFunction, size_t threads = 0) const;
+
+    /// Returns the nearest source node for each node reachable from any of the \p sources.
+    /*!
+        The function uses the multi-source Dijkstra algorithm: the search starts
+        from all sources at once, so a single pass partitions the graph into the
+        sources' regions (a graph Voronoi diagram). The sources that are not in
+        the graph are ignored.
+
+        \param sources A container of the source nodes
+        \param weightFunction A function that calculates a weight for an edge (between to nodes)
+        \return The nearest source and the weight of the path from it for each reachable node.
+    */
+    template <typename Container, typename Func>
+    NearestSources<std::invoke_result_t<Func, const NodeType &, const NodeType &>>
+        nearestSources(const Container &sources, Func weightFunction) const;
+
+    /// Returns the minimum spanning forest of an undirected graph.
+    /*!
+        The function uses the Boruvka's algorithm: in each round every component
+        picks its cheapest outgoing edge and the components are merged along
+        these edges. The rounds run in parallel over the flat edge list with
+        a lock-free union-find. The weight function is called once per edge
+        (as `weightFunction(x, y)` with x < y) before the parallel part, so it
+        doesn't need to be thread-safe. The edges of equal weights are ordered
+        by their nodes, so the result doesn't depend on the number of threads.
+
+        \param weightFunction A function that calculates a weight for an edge (between to nodes)
+        \param threads The number of threads, or zero to use all hardware threads
+        \return The forest edges ordered by their nodes (each edge as x < y).
+    */
+    template <typename Func>
+    Edges minimumSpanningForest(Func weightFunction, size_t threads = 0) const;
+
 private:
 
+    /// Implements the lock-free disjoint set of the indexes [0, size).
+    class ConcurrentUnionFind
+    {
+    public:
+        explicit ConcurrentUnionFind(size_t size);
+
+        /// Returns the representative of the set that contains the \p x.
+        size_t find(size_t x);
+
+        /// Merges the sets of \p x and \p y and returns false if they are already merged.
+        bool unite(size_t x, size_t y);
+
+    private:
+        std::vector<std::atomic<size_t>> m_parents;
+    };
+
+    /// The unknown number of a node.
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+    /// The edge filter that accepts all edges.
+    struct AnyEdge
+    {
+        bool operator()(const NodeType &, const NodeType &) const { return true; }
+    };
+
+    /// The search bound that doesn't limit the search.
+    struct NoBound
+    {
+        template<typename WeightType>
+        bool exceeds(const WeightType &) const { return false; }
+    };
+
+    /// The search bound that doesn't let the search go beyond the given weight.
+    template<typename WeightType>
+    struct MaxWeight
+    {
+        bool exceeds(const WeightType &weight) const { return m_weight < weight; }
+        WeightType m_weight;
+    };
+
     /// The node's weight abstraction.
     template<typename WeightType>
     class Weight
     {
     public:
-        Weight() = default;
-        Weight(const NodeType &from) : m_path{ from } {}
+        using Entry = std::pair<const NodeType, Weight>;
+
         bool infinite() const { return m_infinite; }
         void setWeight(WeightType weight) { m_weight = weight; m_infinite = false; }
         WeightType weight() const { return m_weight; }
-        const Path &path() const { return m_path; }
-        Path &path() { return m_path; }
+        bool settled() const { return m_settled; }
+        void settle() { m_settled = true; }
+        const Entry *previous() const { return m_previous; }
+        void setPrevious(const Entry *previous) { m_previous = previous; }
+        size_t index() const { return m_index; }
+        void setIndex(size_t index) { m_index = index; }
 
     private:
         WeightType m_weight{};
         bool m_infinite{ true };
-        Path m_path;
+        bool m_settled{ false };
+        /// The previous node on the shortest path.
+        const Entry *m_previous{ nullptr };
+        /// The node's number in the weight function's index (see bindTile()).
+        size_t m_index{ npos };
+    };
+
+    /// The search bound that also prunes the paths not shorter than the known path to the target.
+    template<typename WeightType, typename Bound>
+    struct TargetBound
+    {
+        bool exceeds(const WeightType &weight) const
+        {
+            return m_bound.exceeds(weight) ||
+                   (!m_target->infinite() && !(weight < m_target->weight()));
+        }
+        const Weight<WeightType> *m_target;
+        Bound m_bound;
     };
 
-    /// Returns either the shortest path between nodes or shortest paths to all nodes from the given.
+    /// The nodes' weights. The map nodes are stable, so that the entries can refer to each other.
+    /*!
+        The entries are never erased during a search, so they are allocated from
+        a monotonic buffer that is released at once when the search is over.
+    */
+    template<typename WeightType>
+    using Weights = std::pmr::map<NodeType, Weight<WeightType>>;
+
+    /// Runs the Dijkstra search from the source nodes [\p first, \p last).
+    /*!
+        The sources that are not in the graph are ignored.
+        The search only follows the edges for which the \p edgeFilter returns true
+        and doesn't reach the nodes which weights exceed the \p bound. The \p visitor
+        is called with the weights' entry of each node as soon as the node is settled.
+        The search stops if the visitor returns false.
+
+        The query kind (single target, all targets, bounded) is defined by the
+        visitor and the bound types, so that each kind compiles to its own loop.
+        The weights of a node's edges are taken with bindTile() once the node is settled.
+    */
+    template <typename WeightType, typename Iterator, typename Func, typename Filter,
+              typename Bound, typename Visitor>
+    void search(Iterator first, Iterator last, Func weightFunction, Filter edgeFilter,
+                Bound bound, Weights<WeightType> &weights, Visitor visitor) const;
+
+    /// The search queue: a heap of the reached nodes' weights and entries.
+    template<typename WeightType>
+    using Queue = std::vector<std::pair<WeightType, typename Weights<WeightType>::value_type *>>;
+
+    /// Same as above, but keeps the queue in the given empty \p queue, so it can be reused.
+    template <typename WeightType, typename Iterator, typename Func, typename Filter,
+              typename Bound, typename Visitor>
+    void search(Iterator first, Iterator last, Func weightFunction, Filter edgeFilter,
+                Bound bound, Weights<WeightType> &weights, Queue<WeightType> &queue,
+                Visitor visitor) const;
+
+    /// Whether the \p Func object provides the weights of a node's edges with `tile(args...)`.
+    template<typename Void, typename Func, typename ... Args>
+    struct HasTile : std::false_type {};
+
+    template<typename Func, typename ... Args>
+    struct HasTile<std::void_t<decltype(std::declval<const Func &>().tile(
+                       std::declval<const Args &>()...))>, Func, Args...> : std::true_type {};
+
+    /// The weights of the edges of a node for the functions that don't provide `tile()`.
+    template<typename Func>
+    class TileFunction
+    {
+    public:
+        TileFunction(const Func &function, const NodeType &tile)
+            : m_function(&function), m_tile(&tile) {}
+
+        template<typename ... Args>
+        auto operator()(const NodeType &head, const Args & ... args) const
+        {
+            return (*m_function)(*m_tile, head, args...);
+        }
+
+        /// The heads' numbers are unknown.
+        static size_t index() { return npos; }
+
+    private:
+        const Func *m_function;
+        const NodeType *m_tile;
+    };
+
+    /// The travel times of the edges departing from the nodes at their arrival times.
+    /*!
+        The weight function of the time-dependent search: the search passes
+        the time elapsed till the arrival to a node to its tile().
+    */
+    template<typename Func, typename TimeType>
+    class TravelTimes
+    {
+    public:
+        TravelTimes(const Func &travelTime, TimeType departureTime)
+            : m_travelTime(travelTime), m_departureTime(departureTime) {}
+
+        template<typename WeightType>
+        auto tile(const NodeType &node, size_t index, const WeightType &elapsed) const
+        {
+            using Tile = decltype(bindTile(m_travelTime, node, index));
+            using Time = decltype(m_departureTime + elapsed);
+            return Departure<Tile, Time>{ bindTile(m_travelTime, node, index),
+                                          m_departureTime + elapsed };
+        }
+
+    private:
+        /// The travel times of a node's edges for the given departure time.
+        template<typename Tile, typename Time>
+        struct Departure
+        {
+            auto operator()(const NodeType &head) { return m_tile(head, m_time); }
+            size_t index() const { return m_tile.index(); }
+
+            Tile m_tile;
+            Time m_time;
+        };
+
+        Func m_travelTime;
+        TimeType m_departureTime;
+    };
+
+    /// Returns the function or the object that the \p function refers to.
+    template<typename Func>
+    static const Func &unwrap(const Func &function);
+
+    template<typename Func>
+    static const Func &unwrap(const std::reference_wrapper<Func> &function);
+
+    /// Returns the weight function of the edges of the node \p tile: `weight(head, args...)`.
+    /*!
+        If the \p function provides `tile(node, index)`, e.g. GeoEdgeWeights, it's used
+        to look up all edges of the node at once rather than each edge separately. The
+        result's `index()` is the number of the head of the last edge looked up, which
+        the search keeps with the head and passes back as the \p index once the head is
+        settled, so that the function needn't look up the node itself. The \p index is
+        npos if the number is unknown.
+
+        The weights that depend on the state of the node \p tile (e.g. TravelTimes on
+        the arrival time) are provided by `tile(node, index, args...)` and the search
+        passes the state as the \p args explicitly.
+    */
+    template<typename Func, typename ... Args>
+    static auto bindTile(const Func &function, const NodeType &tile, size_t index,
+                         const Args & ... args);
+
+    /// Restores the path to the node of the given weights' \p entry.
+    template <typename Entry>
+    static void tracePath(const Entry &entry, Path &path);
+
+    /// Calls the \p visitor and returns false if the visitor requests to stop.
+    template <typename Visitor, typename ... Args>
+    static bool visit(Visitor &visitor, Args && ... args);
+
+    /// Returns the shortest path between nodes or an empty path if there is no path.
+    /*!
+        The search only follows the edges for which the \p edgeFilter returns true
+        and doesn't go beyond the \p bound.
+    */
+    template <typename Func, typename Filter, typename Bound>
+    Path findPath(const NodeType &from, const NodeType &to, Func weightFunction,
+                  Filter edgeFilter, Bound bound) const;
+
+    /// Same as above, but searches in the given empty \p weights and \p queue, so they can be reused.
+    template <typename WeightType, typename Func, typename Filter, typename Bound>
+    Path findPath(const NodeType &from, const NodeType &to, Func weightFunction,
+                  Filter edgeFilter, Bound bound, Weights<WeightType> &weights,
+                  Queue<WeightType> &queue) const;
+
+    /// Returns the shortest paths from the given node to all nodes within the \p bound.
+    template <typename Func, typename Bound>
+    Paths findPaths(const NodeType &from, Func weightFunction, Bound bound) const;
+
+    /// Returns the total weight of the given path.
     template <typename Func>
-    std::any getAnyPath(const NodeType &from, Func weightFunction,
-                        const std::optional<NodeType> &to = std::nullopt) const;
+    auto pathWeight(const Path &path, Func weightFunction) const;
+
+    template<typename T>
+    using Rebind = typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
+
+    using Neighbours = std::set<NodeType, std::less<NodeType>, Rebind<NodeType>>;
+    using AdjacencyList = std::map<NodeType, Neighbours, std::less<NodeType>,
+                                   Rebind<std::pair<const NodeType, Neighbours>>>;
 
     /// The graph itself.
-    std::map<NodeType, std::set<NodeType>> m_adjacencyList;
+    AdjacencyList m_adjacencyList;
+
+    /// The number of edges.
+    size_t m_size{};
 };
 
+/// The graph that allocates its storage from a `std::pmr::memory_resource`.
+template<typename NodeType, GraphType GT = GraphType::Directed>
+using PmrGraphene = Graphene<NodeType, GT, std::pmr::polymorphic_allocator<NodeType>>;
+
 ////////////////////////////////////////////////////////////////////////////////
 // Definition of the function templates
-template<typename NodeType, GraphType GT>
+template<typename NodeType, GraphType GT, typename Allocator>
+Graphene<NodeType, GT, Allocator>::Graphene(const Allocator &allocator)
+    :
+        m_adjacencyList(typename AdjacencyList::allocator_type(allocator))
+{}
+
+template<typename NodeType, GraphType GT, typename Allocator>
 template<typename UR>
-void Graphene<NodeType, GT>::addNode(UR && node)
+void Graphene<NodeType, GT, Allocator>::addNode(UR && node)
 {
     m_adjacencyList[std::forward<UR>(node)];
 }
 
-template<typename NodeType, GraphType GT>
+template<typename NodeType, GraphType GT, typename Allocator>
 template<typename UR>
-void Graphene<NodeType, GT>::addEdge(UR && tile, UR && head)
+void Graphene<NodeType, GT, Allocator>::addEdge(UR && tile, UR && head)
 {
     auto &headNeighbours = m_adjacencyList[std::forward<UR>(head)];
     auto &tileNeighbours = m_adjacencyList[std::forward<UR>(tile)];
 
     // Link tile -> head
-    tileNeighbours.emplace(std::forward<UR>(head));
+    m_size += tileNeighbours.emplace(std::forward<UR>(head)).second;
 
     // C++17
     if constexpr (GT == GraphType::Undirected) {
         // Link head -> tile
-        headNeighbours.emplace(std::forward<UR>(tile));
+        m_size += headNeighbours.emplace(std::forward<UR>(tile)).second;
     }
 }
 
-template<typename NodeType, GraphType GT>
-size_t Graphene<NodeType, GT>::order() const
+template<typename NodeType, GraphType GT, typename Allocator>
+size_t Graphene<NodeType, GT, Allocator>::order() const
 {
     return m_adjacencyList.size();
 }
 
-template<typename NodeType, GraphType GT>
-size_t Graphene<NodeType, GT>::size() const
+template<typename NodeType, GraphType GT, typename Allocator>
+size_t Graphene<NodeType, GT, Allocator>::size() const
 {
-    size_t r{0};
-    for (const auto &i : m_adjacencyList) {
-        r += i.second.size();
-    }
-    return r;
+    return m_size;
+}
+
+template<typename NodeType, GraphType GT, typename Allocator>
+typename Graphene<NodeType, GT, Allocator>::MemoryUsage
+Graphene<NodeType, GT, Allocator>::memoryUsage() const
+{
+    // The red-black tree node header: the color and three links.
+    static constexpr size_t treeNodeHeader = 4 * sizeof(void *);
+
+    MemoryUsage usage;
+    usage.nodes = order() * sizeof(NodeType);
+    usage.adjacency = sizeof(*this) +
+                      order() * (treeNodeHeader + sizeof(Neighbours)) +
+                      size() * (treeNodeHeader + sizeof(NodeType));
+    return usage;
 }
 
-template<typename NodeType, GraphType GT>
-size_t Graphene<NodeType, GT>::nodeDegree(const NodeType &node) const
+template<typename NodeType, GraphType GT, typename Allocator>
+size_t Graphene<NodeType, GT, Allocator>::nodeDegree(const NodeType &node) const
 {
     auto it = m_adjacencyList.find(node);
     if (it != m_adjacencyList.cend()) {
@@ -177,8 +622,8 @@ size_t Graphene<NodeType, GT>::nodeDegree(const NodeType &node) const
     return 0;
 }
 
-template<typename NodeType, GraphType GT>
-bool Graphene<NodeType, GT>::adjacent(const NodeType &x, const NodeType &y) const
+template<typename NodeType, GraphType GT, typename Allocator>
+bool Graphene<NodeType, GT, Allocator>::adjacent(const NodeType &x, const NodeType &y) const
 {
     auto it = m_adjacencyList.find(x);
     if (it != m_adjacencyList.cend()) {
@@ -190,101 +635,694 @@ bool Graphene<NodeType, GT>::adjacent(const NodeType &x, const NodeType &y) cons
     return false;
 }
 
-template<typename NodeType, GraphType GT>
+template<typename NodeType, GraphType GT, typename Allocator>
 template<typename Func>
-typename Graphene<NodeType, GT>::Path
-    Graphene<NodeType, GT>::shortestPath(const NodeType &from,
-                                         const NodeType &to,
-                                         Func weight) const
+void Graphene<NodeType, GT, Allocator>::forEachNode(Func func) const
 {
-    return std::any_cast<Graphene<NodeType, GT>::Path>(getAnyPath(from, weight, to));
+    for (const auto &node : m_adjacencyList) {
+        func(node.first);
+    }
 }
 
-template<typename NodeType, GraphType GT>
+template<typename NodeType, GraphType GT, typename Allocator>
 template<typename Func>
-typename Graphene<NodeType, GT>::Paths
-Graphene<NodeType, GT>::shortestPaths(const NodeType &from, Func weight) const
+void Graphene<NodeType, GT, Allocator>::forEachEdge(Func func) const
 {
-    return std::any_cast<Graphene<NodeType, GT>::Paths>(getAnyPath(from, weight));
+    for (const auto &node : m_adjacencyList) {
+        for (const auto &adjacent : node.second) {
+            func(node.first, adjacent);
+        }
+    }
 }
 
-template<typename NodeType, GraphType GT>
+template<typename NodeType, GraphType GT, typename Allocator>
 template<typename Func>
-std::any Graphene<NodeType, GT>::getAnyPath(const NodeType &from, Func weight,
-                                            const std::optional<NodeType> &to) const
-{
-    if (m_adjacencyList.find(from) == m_adjacencyList.cend()) {
-        if (to) {
-            return Graphene<NodeType, GT>::Path{};
-        } else {
-            return Graphene<NodeType, GT>::Paths{};
-        }
+typename Graphene<NodeType, GT, Allocator>::Path
+    Graphene<NodeType, GT, Allocator>::shortestPath(const NodeType &from,
+                                                    const NodeType &to,
+                                                    Func weight) const
+{
+    return findPath(from, to, weight, AnyEdge{}, NoBound{});
+}
+
+template<typename NodeType, GraphType GT, typename Allocator>
+template<typename Func>
+typename Graphene<NodeType, GT, Allocator>::Path
+    Graphene<NodeType, GT, Allocator>::shortestPath(const NodeType &from,
+                                                    const NodeType &to,
+                                                    Func weight,
+                                                    std::invoke_result_t<Func, const NodeType &, const NodeType &> maxWeight) const
+{
+    return findPath(from, to, weight, AnyEdge{}, MaxWeight<decltype(maxWeight)>{ maxWeight });
+}
+
+template<typename NodeType, GraphType GT, typename Allocator>
+template<typename Func>
+typename Graphene<NodeType, GT, Allocator>::Paths
+Graphene<NodeType, GT, Allocator>::shortestPaths(const NodeType &from, Func weight) const
+{
+    return findPaths(from, weight, NoBound{});
+}
+
+template<typename NodeType, GraphType GT, typename Allocator>
+template<typename Func>
+typename Graphene<NodeType, GT, Allocator>::Paths
+Graphene<NodeType, GT, Allocator>::shortestPaths(const NodeType &from, Func weight,
+                                                 std::invoke_result_t<Func, const NodeType &, const NodeType &> maxWeight) const
+{
+    return findPaths(from, weight, MaxWeight<decltype(maxWeight)>{ maxWeight });
+}
+
+template<typename NodeType, GraphType GT, typename Allocator>
+template<typename Func>
+typename Graphene<NodeType, GT, Allocator>::Paths
+Graphene<NodeType, GT, Allocator>::kShortestPaths(const NodeType &from, const NodeType &to,
+                                                  size_t k, Func weight, size_t threads) const
+{
+    Paths paths;
+    if (k == 0 || m_adjacencyList.find(from) == m_adjacencyList.cend()) {
+        return paths;
     }
 
-    if (to && m_adjacencyList.find(to.value()) == m_adjacencyList.cend()) {
-        return Graphene<NodeType, GT>::Path{};
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
     }
 
     using WeightType = decltype(weight(from, from));
-    using Pair = std::pair<WeightType, NodeType>;
 
-    // A priority queue - the smallest element on top
-    std::priority_queue<Pair, std::vector<Pair>, std::greater<Pair>> queue;
+    // Take the weights once, so that the parallel searches don't call the function.
+    const EdgeTable<NodeType, WeightType> table(*this, weight);
 
-    std::map<NodeType, Weight<WeightType>> nodeWeights;
+    auto path = findPath(from, to, std::cref(table), AnyEdge{}, NoBound{});
+    if (path.empty()) {
+        return paths;
+    }
+    paths.emplace_back(std::move(path));
 
-    // Initialize with the source node.
-    queue.push({ WeightType{}, from });
-    nodeWeights.emplace(from, Weight<WeightType>{from});
+    // The search state of a thread. The pool keeps the memory of the weights
+    // between the searches, and the queue keeps its storage.
+    struct Workspace
+    {
+        std::pmr::unsynchronized_pool_resource pool;
+        Weights<WeightType> weights{ &pool };
+        Queue<WeightType> queue;
+        std::vector<NodeType> removedNodes;
+        std::vector<NodeType> removedHeads;
+    };
+    std::vector<std::unique_ptr<Workspace>> workspaces(threads);
 
-    while (!queue.empty()) {
-        // Make a copy!
-        auto node = queue.top().second;
-        queue.pop();
-        const auto &nodeWeight = nodeWeights[node];
-
-        // Return as soon as the destination node is found.
-        if (to && node == to) {
-            return nodeWeight.path();
+    // The candidate paths ordered by their weights. The set also rejects duplicates.
+    std::set<std::pair<WeightType, Path>> candidates;
+
+    // The weights of the previous path's prefixes.
+    std::vector<WeightType> rootWeights;
+
+    // The spur path and its total weight for each node of the previous path.
+    std::vector<std::pair<WeightType, Path>> spurs;
+
+    while (paths.size() < k) {
+        const auto &previous = paths.back();
+
+        rootWeights.assign(1, WeightType{});
+        for (size_t i = 1; i < previous.size(); ++i) {
+            rootWeights.emplace_back(rootWeights.back() + table(previous[i - 1], previous[i]));
         }
 
-        auto it = m_adjacencyList.find(node);
-        if (it != m_adjacencyList.cend()) {
-            for (const auto &adjacent : it->second) {
-                const auto edgeWeight = weight(node, adjacent);
+        spurs.assign(previous.size() - 1, {});
+
+        parallelFor(spurs.size(), threads, 1, [&](size_t thread, size_t first, size_t last) {
+            auto &workspace = workspaces[thread];
+            if (!workspace) {
+                workspace = std::make_unique<Workspace>();
+            }
+
+            // The root path nodes must not appear in the spur paths to keep them loopless.
+            auto &removedNodes = workspace->removedNodes;
+            removedNodes.assign(previous.cbegin(), previous.cbegin() + first);
+            std::sort(removedNodes.begin(), removedNodes.end());
+
+            for (auto i = first; i < last; ++i) {
+                const auto &spurNode = previous[i];
+
+                // Mask the next edge of all found paths that share the same root path.
+                auto &removedHeads = workspace->removedHeads;
+                removedHeads.clear();
+                for (const auto &found : paths) {
+                    if (found.size() > i + 1 &&
+                        std::equal(previous.cbegin(), previous.cbegin() + i + 1, found.cbegin())) {
+                        removedHeads.emplace_back(found[i + 1]);
+                    }
+                }
+                std::sort(removedHeads.begin(), removedHeads.end());
+
+                auto filter = [&](const NodeType &x, const NodeType &y) {
+                    return !std::binary_search(removedNodes.cbegin(), removedNodes.cend(), y) &&
+                           (x != spurNode ||
+                            !std::binary_search(removedHeads.cbegin(), removedHeads.cend(), y));
+                };
+
+                workspace->weights.clear();
+                workspace->queue.clear();
+
+                auto spurPath = findPath(spurNode, to, std::cref(table), filter, NoBound{},
+                                         workspace->weights, workspace->queue);
+                removedNodes.insert(std::upper_bound(removedNodes.cbegin(), removedNodes.cend(),
+                                                     spurNode), spurNode);
+                if (spurPath.empty()) {
+                    continue;
+                }
+
+                // Sum the weights in the path order, so that the same path has the same weight.
+                auto &spur = spurs[i];
+                spur.first = rootWeights[i];
+                for (size_t j = 1; j < spurPath.size(); ++j) {
+                    spur.first += table(spurPath[j - 1], spurPath[j]);
+                }
+
+                spur.second.assign(previous.cbegin(), previous.cbegin() + i);
+                spur.second.insert(spur.second.end(), spurPath.cbegin(), spurPath.cend());
+            }
+        });
+
+        for (auto &spur : spurs) {
+            if (!spur.second.empty()) {
+                candidates.emplace(std::move(spur));
+            }
+        }
+
+        if (candidates.empty()) {
+            break;
+        }
+
+        auto best = candidates.extract(candidates.begin());
+        paths.emplace_back(std::move(best.value().second));
+    }
+
+    return paths;
+}
+
+template<typename NodeType, GraphType GT, typename Allocator>
+template<typename Func>
+auto Graphene<NodeType, GT, Allocator>::pathWeight(const Path &path, Func weight) const
+{
+    decltype(weight(path.front(), path.front())) result{};
+    for (size_t i = 1; i < path.size(); ++i) {
+        result += weight(path[i - 1], path[i]);
+    }
+    return result;
+}
+
+template<typename NodeType, GraphType GT, typename Allocator>
+template<typename Container, typename Func>
+typename Graphene<NodeType, GT, Allocator>::template
+    NearestSources<std::invoke_result_t<Func, const NodeType &, const NodeType &>>
+Graphene<NodeType, GT, Allocator>::nearestSources(const Container &sources, Func weight) const
+{
+    using WeightType = std::invoke_result_t<Func, const NodeType &, const NodeType &>;
+    NearestSources<WeightType> result;
+
+    std::pmr::monotonic_buffer_resource buffer;
+    Weights<WeightType> weights(&buffer);
+
+    // A node has the same source as the previous node on its path,
+    // which is always settled earlier.
+    search(std::cbegin(sources), std::cend(sources), weight, AnyEdge{}, NoBound{}, weights,
+           [&](const auto &entry) {
+        const auto *previous = entry.second.previous();
+        const auto &source = previous ? result.find(previous->first)->second.source : entry.first;
+        result.emplace(entry.first, NearestSource<WeightType>{ source, entry.second.weight() });
+        return true;
+    });
+
+    return result;
+}
+
+template<typename NodeType, GraphType GT, typename Allocator>
+template<typename Func>
+typename Graphene<NodeType, GT, Allocator>::Edges
+Graphene<NodeType, GT, Allocator>::minimumSpanningForest(Func weight, size_t threads) const
+{
+    static_assert(GT == GraphType::Undirected, "The spanning forest requires an undirected graph");
+
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Don't start threads for the small amount of work.
+    static constexpr size_t minChunk = 4096;
+
+    // Index the nodes, so that the parallel part works on the flat arrays only.
+    std::vector<const NodeType *> nodes;
+    nodes.reserve(order());
+    for (const auto &node : m_adjacencyList) {
+        nodes.emplace_back(&node.first);
+    }
+
+    auto index = [&](const NodeType &node) -> size_t {
+        return std::lower_bound(nodes.cbegin(), nodes.cend(), &node,
+                                [](const NodeType *x, const NodeType *y) { return *x < *y; }) -
+               nodes.cbegin();
+    };
+
+    using WeightType = decltype(weight(*nodes.front(), *nodes.front()));
+
+    // Each edge once: x < y.
+    std::vector<std::pair<size_t, size_t>> edges;
+    std::vector<WeightType> weights;
+    edges.reserve(size() / 2);
+    weights.reserve(size() / 2);
+
+    for (size_t x = 0; x < nodes.size(); ++x) {
+        const auto &neighbours = m_adjacencyList.find(*nodes[x])->second;
+        for (auto it = neighbours.upper_bound(*nodes[x]); it != neighbours.cend(); ++it) {
+            edges.emplace_back(x, index(*it));
+            weights.emplace_back(weight(*nodes[x], *it));
+        }
+    }
+
+    // The edges are ordered by weights and then by their indexes, which are ordered by nodes.
+    auto lighter = [&](size_t e1, size_t e2) {
+        if (weights[e1] < weights[e2]) {
+            return true;
+        } else if (weights[e2] < weights[e1]) {
+            return false;
+        }
+        return e1 < e2;
+    };
+
+    static constexpr auto none = std::numeric_limits<size_t>::max();
+
+    ConcurrentUnionFind components(nodes.size());
+    std::vector<std::atomic<size_t>> cheapest(nodes.size());
+    std::vector<std::vector<size_t>> selected(threads);
 
-                // If there is shorted path to 'adjacent' through 'node'.
-                auto &adjacentWeight = nodeWeights[adjacent];
-                const auto totalWeight = nodeWeight.weight() + edgeWeight;
+    // The indexes of the edges that still connect different components.
+    std::vector<size_t> candidates(edges.size());
+    for (size_t e = 0; e < edges.size(); ++e) {
+        candidates[e] = e;
+    }
+
+    while (!candidates.empty()) {
+        for (auto &edge : cheapest) {
+            edge.store(none, std::memory_order_relaxed);
+        }
 
-                if (adjacentWeight.infinite() || (adjacentWeight.weight() > totalWeight)) {
-                    adjacentWeight.setWeight(totalWeight);
+        // Find the cheapest edge of each component.
+        parallelFor(candidates.size(), threads, minChunk, [&](size_t, size_t first, size_t last) {
+            for (auto i = first; i < last; ++i) {
+                const auto e = candidates[i];
+                const auto x = components.find(edges[e].first);
+                const auto y = components.find(edges[e].second);
+                if (x == y) {
+                    continue;
+                }
 
-                    auto &adjacentPath = adjacentWeight.path();
-                    adjacentPath = nodeWeight.path();
-                    adjacentPath.emplace_back(adjacent);
+                for (auto component : { x, y }) {
+                    auto current = cheapest[component].load();
+                    while ((current == none || lighter(e, current)) &&
+                           !cheapest[component].compare_exchange_weak(current, e)) {
+                    }
+                }
+            }
+        });
 
-                    queue.push({adjacentWeight.weight(), adjacent});
+        // Merge the components along their cheapest edges.
+        parallelFor(nodes.size(), threads, minChunk, [&](size_t thread, size_t first, size_t last) {
+            for (auto x = first; x < last; ++x) {
+                const auto e = cheapest[x].load();
+                if (e != none && components.unite(edges[e].first, edges[e].second)) {
+                    selected[thread].emplace_back(e);
                 }
             }
+        });
+
+        // Drop the edges inside the components.
+        candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [&](size_t e) {
+            return components.find(edges[e].first) == components.find(edges[e].second);
+        }), candidates.end());
+    }
+
+    std::vector<size_t> forest;
+    for (const auto &chosen : selected) {
+        forest.insert(forest.end(), chosen.cbegin(), chosen.cend());
+    }
+    std::sort(forest.begin(), forest.end());
+
+    Edges result;
+    result.reserve(forest.size());
+    for (auto e : forest) {
+        result.emplace_back(*nodes[edges[e].first], *nodes[edges[e].second]);
+    }
+
+    return result;
+}
+
+template<typename NodeType, GraphType GT, typename Allocator>
+Graphene<NodeType, GT, Allocator>::ConcurrentUnionFind::ConcurrentUnionFind(size_t size)
+    :
+        m_parents(size)
+{
+    for (size_t i = 0; i < size; ++i) {
+        m_parents[i].store(i, std::memory_order_relaxed);
+    }
+}
+
+template<typename NodeType, GraphType GT, typename Allocator>
+size_t Graphene<NodeType, GT, Allocator>::ConcurrentUnionFind::find(size_t x)
+{
+    while (true) {
+        auto parent = m_parents[x].load();
+        if (parent == x) {
+            return x;
+        }
+
+        // Path halving.
+        const auto grandParent = m_parents[parent].load();
+        if (parent != grandParent) {
+            m_parents[x].compare_exchange_weak(parent, grandParent);
         }
+        x = grandParent;
     }
+}
+
+template<typename NodeType, GraphType GT, typename Allocator>
+bool Graphene<NodeType, GT, Allocator>::ConcurrentUnionFind::unite(size_t x, size_t y)
+{
+    while (true) {
+        x = find(x);
+        y = find(y);
+        if (x == y) {
+            return false;
+        }
+
+        // Always link the greater root to the smaller one.
+        if (x < y) {
+            std::swap(x, y);
+        }
+
+        auto expected = x;
+        if (m_parents[x].compare_exchange_strong(expected, y)) {
+            return true;
+        }
+    }
+}
+
+template<typename NodeType, GraphType GT, typename Allocator>
+template<typename TimeType, typename Func>
+typename Graphene<NodeType, GT, Allocator>::Path
+Graphene<NodeType, GT, Allocator>::earliestArrivalPath(const NodeType &from, const NodeType &to,
+                                                       TimeType departureTime,
+                                                       Func travelTime) const
+{
+    Path path;
 
-    if (to) {
-        // If we here the path isn't found.
-        return Path{};
+    if (m_adjacencyList.find(to) == m_adjacencyList.cend()) {
+        return path;
     }
 
+    using WeightType = decltype(travelTime(from, from, departureTime));
+    std::pmr::monotonic_buffer_resource buffer;
+    Weights<WeightType> weights(&buffer);
+
+    // The weights are the times elapsed since the departure, the search passes
+    // them to the travel times of the edges of each settled node.
+    const TravelTimes<Func, TimeType> travelTimes(travelTime, departureTime);
+
+    auto run = [&](auto bound) {
+        search(&from, &from + 1, travelTimes, AnyEdge{}, bound, weights, [&](const auto &entry) {
+            if (entry.first == to) {
+                tracePath(entry, path);
+                return false;
+            }
+            return true;
+        });
+    };
+
+    if constexpr (std::numeric_limits<WeightType>::has_infinity) {
+        // Don't traverse the edges with the infinite travel time.
+        run(MaxWeight<WeightType>{ std::numeric_limits<WeightType>::max() });
+    } else {
+        run(NoBound{});
+    }
+
+    return path;
+}
+
+template<typename NodeType, GraphType GT, typename Allocator>
+template<typename Func, typename Visitor>
+void Graphene<NodeType, GT, Allocator>::forEachShortestPath(const NodeType &from, Func weight,
+                                                            Visitor visitor) const
+{
+    using WeightType = decltype(weight(from, from));
+    std::pmr::monotonic_buffer_resource buffer;
+    Weights<WeightType> weights(&buffer);
+    Path path;
+
+    search(&from, &from + 1, weight, AnyEdge{}, NoBound{}, weights, [&](const auto &entry) {
+        tracePath(entry, path);
+        return visit(visitor, static_cast<const Path &>(path));
+    });
+}
+
+template<typename NodeType, GraphType GT, typename Allocator>
+template<typename Func, typename Visitor>
+void Graphene<NodeType, GT, Allocator>::forEachSettledNode(const NodeType &from, Func weight,
+                                                           Visitor visitor) const
+{
+    using WeightType = decltype(weight(from, from));
+    std::pmr::monotonic_buffer_resource buffer;
+    Weights<WeightType> weights(&buffer);
+
+    search(&from, &from + 1, weight, AnyEdge{}, NoBound{}, weights, [&](const auto &entry) {
+        const auto *previous = entry.second.previous();
+        return visit(visitor, entry.first, previous ? previous->first : entry.first,
+                     entry.second.weight());
+    });
+}
+
+template<typename NodeType, GraphType GT, typename Allocator>
+template<typename Func, typename Filter, typename Bound>
+typename Graphene<NodeType, GT, Allocator>::Path
+Graphene<NodeType, GT, Allocator>::findPath(const NodeType &from, const NodeType &to, Func weight,
+                                            Filter edgeFilter, Bound bound) const
+{
+    using WeightType = decltype(weight(from, from));
+    std::pmr::monotonic_buffer_resource buffer;
+    Weights<WeightType> weights(&buffer);
+    Queue<WeightType> queue;
+
+    return findPath(from, to, weight, edgeFilter, bound, weights, queue);
+}
+
+template<typename NodeType, GraphType GT, typename Allocator>
+template<typename WeightType, typename Func, typename Filter, typename Bound>
+typename Graphene<NodeType, GT, Allocator>::Path
+Graphene<NodeType, GT, Allocator>::findPath(const NodeType &from, const NodeType &to, Func weight,
+                                            Filter edgeFilter, Bound bound,
+                                            Weights<WeightType> &weights,
+                                            Queue<WeightType> &queue) const
+{
+    Path path;
+
+    if (m_adjacencyList.find(to) == m_adjacencyList.cend()) {
+        return path;
+    }
+
+    // The edges that don't lead to a shorter path than the already found
+    // path to the destination are not followed.
+    const auto &target = weights.try_emplace(to).first->second;
+    const TargetBound<WeightType, Bound> targetBound{ &target, bound };
+
+    // Return as soon as the destination node is found.
+    search(&from, &from + 1, weight, edgeFilter, targetBound, weights, queue,
+           [&](const auto &entry) {
+        if (entry.first == to) {
+            tracePath(entry, path);
+            return false;
+        }
+        return true;
+    });
+
+    // The path is empty if it isn't found.
+    return path;
+}
+
+template<typename NodeType, GraphType GT, typename Allocator>
+template<typename Func, typename Bound>
+typename Graphene<NodeType, GT, Allocator>::Paths
+Graphene<NodeType, GT, Allocator>::findPaths(const NodeType &from, Func weight, Bound bound) const
+{
+    using WeightType = decltype(weight(from, from));
+    std::pmr::monotonic_buffer_resource buffer;
+    Weights<WeightType> weights(&buffer);
+
+    search(&from, &from + 1, weight, AnyEdge{}, bound, weights, [](const auto &) { return true; });
+
     Paths paths;
+    paths.reserve(weights.size());
 
-    for (auto && nw : nodeWeights) {
-        paths.emplace_back(nw.second.path());
+    for (auto && entry : weights) {
+        paths.emplace_back();
+        tracePath(entry, paths.back());
     }
 
     return paths;
 }
 
+template<typename NodeType, GraphType GT, typename Allocator>
+template<typename WeightType, typename Iterator, typename Func, typename Filter,
+         typename Bound, typename Visitor>
+void Graphene<NodeType, GT, Allocator>::search(Iterator first, Iterator last, Func weight,
+                                               Filter edgeFilter, Bound bound,
+                                               Weights<WeightType> &weights,
+                                               Visitor visitor) const
+{
+    Queue<WeightType> queue;
+    search(first, last, weight, edgeFilter, bound, weights, queue, visitor);
+}
+
+template<typename NodeType, GraphType GT, typename Allocator>
+template<typename WeightType, typename Iterator, typename Func, typename Filter,
+         typename Bound, typename Visitor>
+void Graphene<NodeType, GT, Allocator>::search(Iterator first, Iterator last, Func weight,
+                                               Filter edgeFilter, Bound bound,
+                                               Weights<WeightType> &weights,
+                                               Queue<WeightType> &queue,
+                                               Visitor visitor) const
+{
+    using Entry = typename Weights<WeightType>::value_type;
+    using Pair = typename Queue<WeightType>::value_type;
 
+    // Orders the queue by weights and then by nodes - the smallest element on top.
+    auto greater = [](const Pair &x, const Pair &y) {
+        if (y.first < x.first) {
+            return true;
+        } else if (x.first < y.first) {
+            return false;
+        }
+        return y.second->first < x.second->first;
+    };
+
+    auto push = [&](const Pair &pair) {
+        queue.emplace_back(pair);
+        std::push_heap(queue.begin(), queue.end(), greater);
+    };
+
+    // Initialize with the source nodes.
+    for (auto it = first; it != last; ++it) {
+        if (m_adjacencyList.find(*it) == m_adjacencyList.cend()) {
+            continue;
+        }
+
+        // The entry may already exist, but not be reached yet.
+        auto source = weights.try_emplace(*it);
+        if (source.first->second.infinite()) {
+            source.first->second.setWeight(WeightType{});
+            push({ WeightType{}, &*source.first });
+        }
+    }
+
+    while (!queue.empty()) {
+        std::pop_heap(queue.begin(), queue.end(), greater);
+        auto &entry = *queue.back().second;
+        queue.pop_back();
+
+        // Skip the outdated queue elements of the already settled nodes.
+        auto &nodeWeight = entry.second;
+        if (nodeWeight.settled()) {
+            continue;
+        }
+        nodeWeight.settle();
+
+        if (!visitor(static_cast<const Entry &>(entry))) {
+            return;
+        }
+
+        const auto &node = entry.first;
+        auto it = m_adjacencyList.find(node);
+        if (it == m_adjacencyList.cend()) {
+            continue;
+        }
+
+        auto edgeWeight = bindTile(weight, node, nodeWeight.index(), nodeWeight.weight());
+
+        for (const auto &adjacent : it->second) {
+            if (!edgeFilter(node, adjacent)) {
+                continue;
+            }
+
+            const auto totalWeight = nodeWeight.weight() + edgeWeight(adjacent);
+            if (bound.exceeds(totalWeight)) {
+                continue;
+            }
+
+            // If there is shorter path to 'adjacent' through 'node'.
+            auto &adjacentEntry = *weights.try_emplace(adjacent).first;
+            auto &adjacentWeight = adjacentEntry.second;
+
+            if (adjacentWeight.infinite() || (adjacentWeight.weight() > totalWeight)) {
+                adjacentWeight.setWeight(totalWeight);
+                adjacentWeight.setPrevious(&entry);
+                adjacentWeight.setIndex(edgeWeight.index());
+                push({ totalWeight, &adjacentEntry });
+            }
+        }
+    }
+}
+
+template<typename NodeType, GraphType GT, typename Allocator>
+template<typename Func>
+const Func &Graphene<NodeType, GT, Allocator>::unwrap(const Func &function)
+{
+    return function;
+}
+
+template<typename NodeType, GraphType GT, typename Allocator>
+template<typename Func>
+const Func &Graphene<NodeType, GT, Allocator>::unwrap(const std::reference_wrapper<Func> &function)
+{
+    return function.get();
+}
+
+template<typename NodeType, GraphType GT, typename Allocator>
+template<typename Func, typename ... Args>
+auto Graphene<NodeType, GT, Allocator>::bindTile(const Func &function, const NodeType &tile,
+                                                 size_t index, const Args & ... args)
+{
+    const auto &object = unwrap(function);
+    using Object = std::decay_t<decltype(object)>;
+
+    if constexpr (sizeof...(Args) > 0 && HasTile<void, Object, NodeType, size_t, Args...>::value) {
+        return object.tile(tile, index, args...);
+    } else if constexpr (HasTile<void, Object, NodeType, size_t>::value) {
+        return object.tile(tile, index);
+    } else {
+        return TileFunction<Object>(object, tile);
+    }
+}
+
+template<typename NodeType, GraphType GT, typename Allocator>
+template<typename Entry>
+void Graphene<NodeType, GT, Allocator>::tracePath(const Entry &entry, Path &path)
+{
+    path.clear();
+    for (auto current = &entry; current; current = current->second.previous()) {
+        path.emplace_back(current->first);
+    }
+    std::reverse(path.begin(), path.end());
+}
+
+template<typename NodeType, GraphType GT, typename Allocator>
+template<typename Visitor, typename ... Args>
+bool Graphene<NodeType, GT, Allocator>::visit(Visitor &visitor, Args && ... args)
+{
+    if constexpr (std::is_same_v<std::invoke_result_t<Visitor &, Args...>, bool>) {
+        return visitor(std::forward<Args>(args)...);
+    } else {
+        visitor(std::forward<Args>(args)...);
+        return true;
+    }
+}
 
 #endif // !__GRAPHENE_H__
 
@@ -0,0 +1,574 @@
+/**********************************************************************************
+*  MIT License                                                                    *
+*                                                                                 *
+*  Copyright (c) 2023 Vahan Aghajanyan <vahancho@gmail.com>                       *
+*                                                                                 *
+*  Permission is hereby granted, free of charge, to any person obtaining a copy   *
+*  of this software and associated documentation files (the "Software"), to deal  *
+*  in the Software without restriction, including without limitation the rights   *
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+*  copies of the Software, and to permit persons to whom the Software is          *
+*  furnished to do so, subject to the following conditions:                       *
+*                                                                                 *
+*  The above copyright notice and this permission notice shall be included in all *
+*  copies or substantial portions of the Software.                                *
+*                                                                                 *
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+*  SOFTWARE.                                                                      *
+***********************************************************************************/
+
+
+#ifndef __GRAPHINDEX_H__
+#define __GRAPHINDEX_H__
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//! Implements the dense numbering of the graph nodes.
+/*!
+    The nodes are numbered in ascending order, so that the number of a node
+    is found by a binary search over a flat array. The derived structures
+    (edges, weights, coordinates) are then stored in arrays indexed by the
+    nodes' numbers.
+*/
+template<typename NodeType, typename Index = size_t>
+class NodeIndex
+{
+public:
+    /// The number of no node.
+    static constexpr Index npos = std::numeric_limits<Index>::max();
+
+    /// Creates an empty index.
+    NodeIndex() = default;
+
+    /// Numbers the nodes of the \p graph.
+    template<typename Graph>
+    explicit NodeIndex(const Graph &graph);
+
+    /// Returns the number of nodes.
+    size_t size() const;
+
+    /// Returns the number of the \p node or npos if there is no such node.
+    Index index(const NodeType &node) const;
+
+    /// Returns the node with the given number.
+    const NodeType &node(Index index) const;
+
+    /// Returns the number of bytes used by the index.
+    size_t memoryUsage() const;
+
+private:
+    /// The nodes in ascending order.
+    std::vector<NodeType> m_nodes;
+};
+
+//! Implements the graph edges in the compressed sparse row format.
+/*!
+    The edges of each node are stored contiguously in the ascending order of
+    their heads' numbers, so that the data of the edge (tile, head) can be kept
+    in an array indexed by the edge's number.
+*/
+template<typename Index = size_t>
+class EdgeIndex
+{
+public:
+    /// The number of no edge.
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+    /// Creates an empty index.
+    EdgeIndex() = default;
+
+    /// Indexes the edges of the \p graph numbered by the \p nodes.
+    /*!
+        The \p nodes is a NodeIndex or any other object that provides the
+        `size()` and `index(node)` functions of the dense numbering.
+    */
+    template<typename Graph, typename Nodes>
+    EdgeIndex(const Graph &graph, const Nodes &nodes);
+
+    /// Returns the number of edges.
+    size_t size() const;
+
+    /// Returns the number of the first edge of the node \p tile.
+    size_t begin(Index tile) const;
+
+    /// Returns the number following the last edge of the node \p tile.
+    size_t end(Index tile) const;
+
+    /// Returns the head of the \p edge.
+    Index head(size_t edge) const;
+
+    /// Returns the heads of the edges of the node \p tile: [begin(tile), end(tile)).
+    const Index *heads(Index tile) const;
+
+    /// Returns the number of the edge (\p tile, \p head) or npos if there is no such edge.
+    size_t edge(Index tile, Index head) const;
+
+    /// Returns the number of bytes used by the index.
+    size_t memoryUsage() const;
+
+private:
+    std::vector<size_t> m_offsets;
+    std::vector<Index> m_heads;
+};
+
+//! Implements the lookup of the edges of one node by their heads.
+/*!
+    The searches relax the edges of a node in the ascending order of the heads,
+    which is the order of the edges in the EdgeIndex, so the cursor finds the
+    next edge by advancing over the node's edges instead of searching for the
+    heads' numbers. The \p Nodes is a NodeIndex or any other object that
+    provides the `size()` and `node(index)` functions of the dense numbering.
+*/
+template<typename Nodes, typename Index = size_t>
+class EdgeCursor
+{
+public:
+    /// Starts at the first edge of the node \p tile, no edges if it isn't a node's number.
+    EdgeCursor(const Nodes &nodes, const EdgeIndex<Index> &edges, size_t tile);
+
+    /// Returns the number of the edge to the \p head or EdgeIndex::npos if there is no such edge.
+    /*!
+        Takes constant time per edge if the heads come in ascending order and
+        falls back to a binary search otherwise.
+    */
+    template<typename NodeType>
+    size_t edge(const NodeType &head);
+
+private:
+    const Nodes *m_nodes;
+    const EdgeIndex<Index> *m_edges;
+    size_t m_begin{};
+    size_t m_edge{};
+    size_t m_end{};
+};
+
+//! Implements the table of the values of the graph edges, e.g. a snapshot of their weights.
+/*!
+    The table is a weight function for the Graphene's searches: tile() looks up
+    the edges of a node with an EdgeCursor in constant time per edge. Being
+    read-only, the table can be shared by concurrent searches.
+*/
+template<typename NodeType, typename Value>
+class EdgeTable
+{
+public:
+    class Tile;
+
+    /// Takes the values of all edges of the \p graph as `value(tile, head)`.
+    template<typename Graph, typename Func>
+    EdgeTable(const Graph &graph, Func value);
+
+    /// Returns the value of the edge (\p tile, \p head) or missing() if there is no such edge.
+    Value operator()(const NodeType &tile, const NodeType &head) const;
+
+    /// Returns the values of the edges of the \p node as a function of their heads.
+    /*!
+        The \p index is the node's number if it's known, e.g. from the Tile::index()
+        of an edge to the node, or npos. The result is valid as long as the table.
+    */
+    Tile tile(const NodeType &node, size_t index = npos) const;
+
+    /// Returns the value of no edge: infinity or the largest value of the type.
+    static constexpr Value missing();
+
+private:
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+    NodeIndex<NodeType> m_nodes;
+    EdgeIndex<> m_edges;
+    std::vector<Value> m_values;
+};
+
+//! Implements the values of the edges of one node as a function of their heads.
+template<typename NodeType, typename Value>
+class EdgeTable<NodeType, Value>::Tile
+{
+public:
+    Tile(const EdgeTable &table, size_t tile);
+
+    /// Returns the value of the edge to the \p head or missing() if there is no such edge.
+    Value operator()(const NodeType &head);
+
+    /// Returns the number of the last edge's head or npos if there was no such edge.
+    size_t index() const;
+
+private:
+    const EdgeTable *m_table;
+    EdgeCursor<NodeIndex<NodeType>> m_cursor;
+    size_t m_index{ npos };
+};
+
+//! Implements the state of the nodes in a search, reused between the searches.
+/*!
+    A label is valid only if it's stamped by the current search, so that
+    a search resets the labels of the nodes it reaches only and its cost
+    doesn't depend on the size of the graph.
+*/
+template<typename Label>
+class NodeLabels
+{
+public:
+    /// Creates the default labels of \p size nodes.
+    explicit NodeLabels(size_t size);
+
+    /// Starts a new search: all labels become default.
+    void reset();
+
+    /// Returns the label of the node \p x in the current search.
+    Label &operator[](size_t x);
+
+private:
+    std::vector<Label> m_labels;
+    std::vector<uint32_t> m_stamps;
+    uint32_t m_stamp{ 0 };
+};
+
+//! Implements a thread safe pool of the objects reused between the queries.
+/*!
+    Each concurrent query takes its own object, so there are as many objects
+    as the queries that ever ran at the same time. Copying a pool doesn't copy
+    its objects.
+*/
+template<typename Type>
+class Pool
+{
+public:
+    Pool() = default;
+    Pool(const Pool &);
+    Pool &operator=(const Pool &);
+
+    /// Takes a free object or creates a new one from the \p args.
+    template<typename ... Args>
+    std::unique_ptr<Type> acquire(Args && ... args);
+
+    /// Returns the \p object for the next queries.
+    void release(std::unique_ptr<Type> object);
+
+private:
+    std::mutex m_mutex;
+    std::vector<std::unique_ptr<Type>> m_objects;
+};
+
+/// Calls the \p func as `func(thread, first, last)` for the ranges of [0, \p count) in parallel.
+/*!
+    The range is split between at most \p threads threads (all hardware threads
+    if it's zero), but each thread gets at least \p minChunk elements, so that
+    no threads are started for the small amount of work.
+*/
+template<typename Func>
+void parallelFor(size_t count, size_t threads, size_t minChunk, Func func);
+
+////////////////////////////////////////////////////////////////////////////////
+// Definition of the function templates
+template<typename NodeType, typename Index>
+template<typename Graph>
+NodeIndex<NodeType, Index>::NodeIndex(const Graph &graph)
+{
+    m_nodes.reserve(graph.order());
+    graph.forEachNode([this](const NodeType &node) {
+        m_nodes.emplace_back(node);
+    });
+}
+
+template<typename NodeType, typename Index>
+size_t NodeIndex<NodeType, Index>::size() const
+{
+    return m_nodes.size();
+}
+
+template<typename NodeType, typename Index>
+Index NodeIndex<NodeType, Index>::index(const NodeType &node) const
+{
+    auto it = std::lower_bound(m_nodes.cbegin(), m_nodes.cend(), node);
+    if (it == m_nodes.cend() || node < *it) {
+        return npos;
+    }
+    return static_cast<Index>(it - m_nodes.cbegin());
+}
+
+template<typename NodeType, typename Index>
+const NodeType &NodeIndex<NodeType, Index>::node(Index index) const
+{
+    return m_nodes[index];
+}
+
+template<typename NodeType, typename Index>
+size_t NodeIndex<NodeType, Index>::memoryUsage() const
+{
+    return m_nodes.capacity() * sizeof(NodeType);
+}
+
+template<typename Index>
+template<typename Graph, typename Nodes>
+EdgeIndex<Index>::EdgeIndex(const Graph &graph, const Nodes &nodes)
+    :
+        m_offsets(nodes.size() + 1, 0)
+{
+    m_heads.reserve(graph.size());
+
+    // The edges come in the ascending order of their tiles and heads.
+    graph.forEachEdge([&](const auto &tile, const auto &head) {
+        ++m_offsets[nodes.index(tile) + 1];
+        m_heads.emplace_back(static_cast<Index>(nodes.index(head)));
+    });
+
+    for (size_t i = 1; i < m_offsets.size(); ++i) {
+        m_offsets[i] += m_offsets[i - 1];
+    }
+}
+
+template<typename Index>
+size_t EdgeIndex<Index>::size() const
+{
+    return m_heads.size();
+}
+
+template<typename Index>
+size_t EdgeIndex<Index>::begin(Index tile) const
+{
+    return m_offsets[tile];
+}
+
+template<typename Index>
+size_t EdgeIndex<Index>::end(Index tile) const
+{
+    return m_offsets[tile + 1];
+}
+
+template<typename Index>
+Index EdgeIndex<Index>::head(size_t edge) const
+{
+    return m_heads[edge];
+}
+
+template<typename Index>
+const Index *EdgeIndex<Index>::heads(Index tile) const
+{
+    return m_heads.data() + m_offsets[tile];
+}
+
+template<typename Index>
+size_t EdgeIndex<Index>::edge(Index tile, Index head) const
+{
+    if (m_offsets.empty() || tile >= m_offsets.size() - 1) {
+        return npos;
+    }
+
+    const auto first = m_heads.cbegin() + m_offsets[tile];
+    const auto last = m_heads.cbegin() + m_offsets[tile + 1];
+    auto it = std::lower_bound(first, last, head);
+    if (it == last || *it != head) {
+        return npos;
+    }
+    return it - m_heads.cbegin();
+}
+
+template<typename Index>
+size_t EdgeIndex<Index>::memoryUsage() const
+{
+    return m_offsets.capacity() * sizeof(size_t) + m_heads.capacity() * sizeof(Index);
+}
+
+template<typename Nodes, typename Index>
+EdgeCursor<Nodes, Index>::EdgeCursor(const Nodes &nodes, const EdgeIndex<Index> &edges, size_t tile)
+    :
+        m_nodes(&nodes),
+        m_edges(&edges)
+{
+    if (tile < nodes.size()) {
+        m_begin = m_edge = edges.begin(static_cast<Index>(tile));
+        m_end = edges.end(static_cast<Index>(tile));
+    }
+}
+
+template<typename Nodes, typename Index>
+template<typename NodeType>
+size_t EdgeCursor<Nodes, Index>::edge(const NodeType &head)
+{
+    auto headOf = [this](size_t edge) -> decltype(auto) {
+        return m_nodes->node(m_edges->head(edge));
+    };
+
+    while (m_edge < m_end && headOf(m_edge) < head) {
+        ++m_edge;
+    }
+    if (m_edge < m_end && !(head < headOf(m_edge))) {
+        return m_edge;
+    }
+
+    // The head is out of order.
+    auto first = m_begin;
+    auto count = m_edge - m_begin;
+    while (count > 0) {
+        const auto step = count / 2;
+        if (headOf(first + step) < head) {
+            first += step + 1;
+            count -= step + 1;
+        } else {
+            count = step;
+        }
+    }
+    return first < m_edge && !(head < headOf(first)) ? first : EdgeIndex<Index>::npos;
+}
+
+template<typename NodeType, typename Value>
+template<typename Graph, typename Func>
+EdgeTable<NodeType, Value>::EdgeTable(const Graph &graph, Func value)
+    :
+        m_nodes(graph),
+        m_edges(graph, m_nodes)
+{
+    // The edges come in the order of the index.
+    m_values.reserve(m_edges.size());
+    graph.forEachEdge([&](const NodeType &tile, const NodeType &head) {
+        m_values.emplace_back(value(tile, head));
+    });
+}
+
+template<typename NodeType, typename Value>
+Value EdgeTable<NodeType, Value>::operator()(const NodeType &tile, const NodeType &head) const
+{
+    const auto edge = m_edges.edge(m_nodes.index(tile), m_nodes.index(head));
+    return edge == EdgeIndex<>::npos ? missing() : m_values[edge];
+}
+
+template<typename NodeType, typename Value>
+typename EdgeTable<NodeType, Value>::Tile
+EdgeTable<NodeType, Value>::tile(const NodeType &node, size_t index) const
+{
+    return Tile(*this, index == npos ? m_nodes.index(node) : index);
+}
+
+template<typename NodeType, typename Value>
+constexpr Value EdgeTable<NodeType, Value>::missing()
+{
+    return std::numeric_limits<Value>::has_infinity ? std::numeric_limits<Value>::infinity() :
+                                                      std::numeric_limits<Value>::max();
+}
+
+template<typename NodeType, typename Value>
+EdgeTable<NodeType, Value>::Tile::Tile(const EdgeTable &table, size_t tile)
+    :
+        m_table(&table),
+        m_cursor(table.m_nodes, table.m_edges, tile)
+{}
+
+template<typename NodeType, typename Value>
+Value EdgeTable<NodeType, Value>::Tile::operator()(const NodeType &head)
+{
+    const auto edge = m_cursor.edge(head);
+    if (edge == EdgeIndex<>::npos) {
+        m_index = npos;
+        return missing();
+    }
+
+    m_index = m_table->m_edges.head(edge);
+    return m_table->m_values[edge];
+}
+
+template<typename NodeType, typename Value>
+size_t EdgeTable<NodeType, Value>::Tile::index() const
+{
+    return m_index;
+}
+
+template<typename Label>
+NodeLabels<Label>::NodeLabels(size_t size)
+    :
+        m_labels(size),
+        m_stamps(size, 0)
+{}
+
+template<typename Label>
+void NodeLabels<Label>::reset()
+{
+    // Restart the stamps when they wrap around.
+    if (++m_stamp == 0) {
+        std::fill(m_stamps.begin(), m_stamps.end(), 0);
+        m_stamp = 1;
+    }
+}
+
+template<typename Label>
+Label &NodeLabels<Label>::operator[](size_t x)
+{
+    if (m_stamps[x] != m_stamp) {
+        m_stamps[x] = m_stamp;
+        m_labels[x] = Label{};
+    }
+    return m_labels[x];
+}
+
+template<typename Type>
+Pool<Type>::Pool(const Pool &)
+{}
+
+template<typename Type>
+Pool<Type> &Pool<Type>::operator=(const Pool &)
+{
+    return *this;
+}
+
+template<typename Type>
+template<typename ... Args>
+std::unique_ptr<Type> Pool<Type>::acquire(Args && ... args)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_objects.empty()) {
+            auto object = std::move(m_objects.back());
+            m_objects.pop_back();
+            return object;
+        }
+    }
+    return std::make_unique<Type>(std::forward<Args>(args)...);
+}
+
+template<typename Type>
+void Pool<Type>::release(std::unique_ptr<Type> object)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_objects.emplace_back(std::move(object));
+}
+
+template<typename Func>
+void parallelFor(size_t count, size_t threads, size_t minChunk, Func func)
+{
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::max<size_t>(1, std::min(threads, count / std::max<size_t>(1, minChunk)));
+
+    if (threads == 1) {
+        func(0, 0, count);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+
+    const auto chunk = (count + threads - 1) / threads;
+    for (size_t thread = 1; thread < threads; ++thread) {
+        workers.emplace_back(func, thread, std::min(count, thread * chunk),
+                             std::min(count, (thread + 1) * chunk));
+    }
+
+    func(0, 0, std::min(count, chunk));
+
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+#endif // !__GRAPHINDEX_H__
@@ -0,0 +1,492 @@
+/**********************************************************************************
+*  MIT License                                                                    *
+*                                                                                 *
+*  Copyright (c) 2023 Vahan Aghajanyan <vahancho@gmail.com>                       *
+*                                                                                 *
+*  Permission is hereby granted, free of charge, to any person obtaining a copy   *
+*  of this software and associated documentation files (the "Software"), to deal  *
+*  in the Software without restriction, including without limitation the rights   *
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+*  copies of the Software, and to permit persons to whom the Software is          *
+*  furnished to do so, subject to the following conditions:                       *
+*                                                                                 *
+*  The above copyright notice and this permission notice shall be included in all *
+*  copies or substantial portions of the Software.                                *
+*                                                                                 *
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+*  SOFTWARE.                                                                      *
+***********************************************************************************/
+
+
+#ifndef __OVERLAY_H__
+#define __OVERLAY_H__
+
+#include "graphindex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <cstdint>
+#include <limits>
+#include <queue>
+#include <utility>
+#include <vector>
+
+//! Implements a partition of a graph into cells and the overlay of the cells' boundaries.
+/*!
+    The graph nodes are split into cells by the recursive inertial bisection of
+    their coordinates: each set of nodes is cut in halves across its principal
+    axis until the cells are small enough. The boundary nodes (the nodes with
+    edges to other cells) of each cell are connected by the clique of the
+    shortest distances inside the cell.
+
+    A query runs Dijkstra over the original edges only in the source's and the
+    target's cells, everywhere else it uses the cut edges and the cliques, so
+    the interiors of the other cells are skipped. The cells are preprocessed in
+    parallel and each one can be updated separately when its weights change.
+
+    The object works on a snapshot of the graph: the edges' weights are taken
+    once on construction (or on update), so the weight function isn't required
+    to be thread-safe. The queries can run concurrently, each one takes its own
+    reusable workspace, but not together with the updates.
+*/
+template<typename NodeType, typename WeightType = double>
+class Overlay
+{
+public:
+    using Path = std::vector<NodeType>;
+
+    /// The invalid index.
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+    /// Partitions the \p graph and builds the overlay.
+    /*!
+        \param graph The graph
+        \param coordinates A function that returns the (x, y) coordinates of a node
+        \param weightFunction A function that calculates a weight for an edge (between to nodes)
+        \param maxCellSize The maximum number of nodes in a cell
+        \param threads The number of threads, or zero to use all hardware threads
+    */
+    template<typename Graph, typename Accessor, typename Func>
+    Overlay(const Graph &graph, Accessor coordinates, Func weightFunction,
+            size_t maxCellSize, size_t threads = 0);
+
+    /// Returns the number of cells.
+    size_t cellCount() const;
+
+    /// Returns the cell of the \p node or npos if there is no such node.
+    size_t cell(const NodeType &node) const;
+
+    /// Returns the total number of the boundary nodes.
+    size_t boundarySize() const;
+
+    /// Takes the new weights of the edges that start in the \p cell and updates its clique.
+    template<typename Func>
+    void updateCell(size_t cell, Func weightFunction);
+
+    /// Returns the shortest path from the node \p from to the node \p to.
+    Path shortestPath(const NodeType &from, const NodeType &to) const;
+
+private:
+    using Pair = std::pair<WeightType, size_t>;
+    using Queue = std::priority_queue<Pair, std::vector<Pair>, std::greater<Pair>>;
+
+    /// The query state of a reached node.
+    struct Label
+    {
+        WeightType weight{ infinity() };
+        size_t previous{ npos };
+        /// Whether the node is reached through a clique.
+        bool shortcut{ false };
+    };
+
+    /// Splits the nodes [first, last) into cells.
+    void partition(std::vector<size_t>::iterator first, std::vector<size_t>::iterator last,
+                   const std::vector<std::pair<double, double>> &points, size_t maxCellSize);
+
+    /// Recalculates the clique distances of the \p cell.
+    void updateClique(size_t cell, std::vector<WeightType> &weights,
+                      std::vector<size_t> &previous);
+
+    /// Runs Dijkstra from the node \p source inside its cell.
+    /*!
+        The \p weights and the \p previous nodes are indexed by the nodes' positions
+        in the cell. The search stops when the \p target (if not npos) is settled.
+    */
+    void cellSearch(size_t source, size_t target, std::vector<WeightType> &weights,
+                    std::vector<size_t> &previous) const;
+
+    static constexpr WeightType infinity()
+    {
+        return std::numeric_limits<WeightType>::has_infinity ?
+               std::numeric_limits<WeightType>::infinity() :
+               std::numeric_limits<WeightType>::max();
+    }
+
+    NodeIndex<NodeType> m_nodes;
+    EdgeIndex<> m_edges;
+
+    /// The weights of the edges.
+    std::vector<WeightType> m_weights;
+
+    /// The cell of each node and the node's position in it.
+    std::vector<size_t> m_cells;
+    std::vector<size_t> m_positions;
+
+    /// The nodes of each cell.
+    std::vector<size_t> m_cellOffsets;
+    std::vector<size_t> m_cellNodes;
+
+    /// The node's position among its cell's boundary nodes or npos.
+    std::vector<size_t> m_boundary;
+
+    /// The boundary nodes of each cell.
+    std::vector<size_t> m_boundaryOffsets;
+    std::vector<size_t> m_boundaryNodes;
+
+    /// The clique distances of each cell as a row-major matrix.
+    std::vector<size_t> m_cliqueOffsets;
+    std::vector<WeightType> m_cliques;
+
+    /// The query labels of the nodes, one per concurrent query.
+    mutable Pool<NodeLabels<Label>> m_labels;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Definition of the function templates
+template<typename NodeType, typename WeightType>
+template<typename Graph, typename Accessor, typename Func>
+Overlay<NodeType, WeightType>::Overlay(const Graph &graph, Accessor coordinates,
+                                       Func weight, size_t maxCellSize, size_t threads)
+    :
+        m_nodes(graph),
+        m_edges(graph, m_nodes)
+{
+    const auto n = m_nodes.size();
+
+    std::vector<std::pair<double, double>> points;
+    points.reserve(n);
+    m_weights.reserve(m_edges.size());
+
+    for (size_t x = 0; x < n; ++x) {
+        points.emplace_back(coordinates(m_nodes.node(x)));
+        for (auto e = m_edges.begin(x); e < m_edges.end(x); ++e) {
+            m_weights.emplace_back(weight(m_nodes.node(x), m_nodes.node(m_edges.head(e))));
+        }
+    }
+
+    // Partition the nodes.
+    m_cells.assign(n, 0);
+    m_positions.assign(n, 0);
+    m_cellOffsets.assign(1, 0);
+
+    std::vector<size_t> nodes(n);
+    for (size_t i = 0; i < n; ++i) {
+        nodes[i] = i;
+    }
+    partition(nodes.begin(), nodes.end(), points, std::max<size_t>(1, maxCellSize));
+
+    // The cells are the consecutive ranges of the partitioned nodes.
+    m_cellNodes = std::move(nodes);
+
+    // Find the boundary nodes.
+    std::vector<bool> boundary(n, false);
+    for (size_t x = 0; x < n; ++x) {
+        for (auto e = m_edges.begin(x); e < m_edges.end(x); ++e) {
+            if (m_cells[x] != m_cells[m_edges.head(e)]) {
+                boundary[x] = true;
+                boundary[m_edges.head(e)] = true;
+            }
+        }
+    }
+
+    m_boundary.assign(n, npos);
+    m_boundaryOffsets.assign(1, 0);
+    m_cliqueOffsets.assign(1, 0);
+
+    for (size_t c = 0; c < cellCount(); ++c) {
+        for (auto i = m_cellOffsets[c]; i < m_cellOffsets[c + 1]; ++i) {
+            const auto x = m_cellNodes[i];
+            if (boundary[x]) {
+                m_boundary[x] = m_boundaryNodes.size() - m_boundaryOffsets[c];
+                m_boundaryNodes.emplace_back(x);
+            }
+        }
+        m_boundaryOffsets.emplace_back(m_boundaryNodes.size());
+
+        const auto size = m_boundaryOffsets[c + 1] - m_boundaryOffsets[c];
+        m_cliqueOffsets.emplace_back(m_cliqueOffsets.back() + size * size);
+    }
+
+    m_cliques.resize(m_cliqueOffsets.back());
+
+    // Calculate the cliques in parallel.
+    parallelFor(cellCount(), threads, 1, [this](size_t, size_t first, size_t last) {
+        std::vector<WeightType> weights;
+        std::vector<size_t> previous;
+        for (auto c = first; c < last; ++c) {
+            updateClique(c, weights, previous);
+        }
+    });
+}
+
+template<typename NodeType, typename WeightType>
+size_t Overlay<NodeType, WeightType>::cellCount() const
+{
+    return m_cellOffsets.size() - 1;
+}
+
+template<typename NodeType, typename WeightType>
+size_t Overlay<NodeType, WeightType>::cell(const NodeType &node) const
+{
+    const auto i = m_nodes.index(node);
+    return i == npos ? npos : m_cells[i];
+}
+
+template<typename NodeType, typename WeightType>
+size_t Overlay<NodeType, WeightType>::boundarySize() const
+{
+    return m_boundaryNodes.size();
+}
+
+template<typename NodeType, typename WeightType>
+template<typename Func>
+void Overlay<NodeType, WeightType>::updateCell(size_t cell, Func weight)
+{
+    for (auto i = m_cellOffsets[cell]; i < m_cellOffsets[cell + 1]; ++i) {
+        const auto x = m_cellNodes[i];
+        for (auto e = m_edges.begin(x); e < m_edges.end(x); ++e) {
+            m_weights[e] = weight(m_nodes.node(x), m_nodes.node(m_edges.head(e)));
+        }
+    }
+
+    std::vector<WeightType> weights;
+    std::vector<size_t> previous;
+    updateClique(cell, weights, previous);
+}
+
+template<typename NodeType, typename WeightType>
+typename Overlay<NodeType, WeightType>::Path
+Overlay<NodeType, WeightType>::shortestPath(const NodeType &from, const NodeType &to) const
+{
+    const auto source = m_nodes.index(from);
+    const auto target = m_nodes.index(to);
+    if (source == npos || target == npos) {
+        return {};
+    }
+
+    const auto sourceCell = m_cells[source];
+    const auto targetCell = m_cells[target];
+
+    // Only the labels of the reached nodes are reset: the query touches the two
+    // cells and the boundary nodes, so its cost doesn't depend on the size of the graph.
+    auto workspace = m_labels.acquire(m_nodes.size());
+    workspace->reset();
+    auto &labels = *workspace;
+
+    Queue queue;
+    labels[source].weight = WeightType{};
+    queue.push({ WeightType{}, source });
+
+    auto relax = [&](size_t x, WeightType weight, size_t y, WeightType edgeWeight,
+                     bool shortcut) {
+        const auto total = weight + edgeWeight;
+        auto &label = labels[y];
+        if (total < label.weight) {
+            label = { total, x, shortcut };
+            queue.push({ total, y });
+        }
+    };
+
+    while (!queue.empty()) {
+        const auto [weight, x] = queue.top();
+        queue.pop();
+
+        // Skip the outdated elements.
+        if (labels[x].weight < weight) {
+            continue;
+        }
+
+        if (x == target) {
+            break;
+        }
+
+        const auto c = m_cells[x];
+        const auto local = c == sourceCell || c == targetCell;
+
+        for (auto e = m_edges.begin(x); e < m_edges.end(x); ++e) {
+            // Only the cut edges outside of the source and target cells.
+            if (local || m_cells[m_edges.head(e)] != c) {
+                relax(x, weight, m_edges.head(e), m_weights[e], false);
+            }
+        }
+
+        if (!local && m_boundary[x] != npos) {
+            const auto first = m_boundaryOffsets[c];
+            const auto size = m_boundaryOffsets[c + 1] - first;
+            const auto row = m_cliques.cbegin() + m_cliqueOffsets[c] + m_boundary[x] * size;
+
+            for (size_t i = 0; i < size; ++i) {
+                if (row[i] != infinity() && m_boundaryNodes[first + i] != x) {
+                    relax(x, weight, m_boundaryNodes[first + i], row[i], true);
+                }
+            }
+        }
+    }
+
+    if (labels[target].weight == infinity()) {
+        m_labels.release(std::move(workspace));
+        return {};
+    }
+
+    // Unpack the path: the cliques' edges are restored by the searches inside their cells.
+    Path path;
+    std::vector<WeightType> cellWeights;
+    std::vector<size_t> cellPrevious;
+
+    for (auto x = target; x != npos; x = labels[x].previous) {
+        path.emplace_back(m_nodes.node(x));
+
+        const auto &label = labels[x];
+        if (label.shortcut) {
+            const auto first = m_cellOffsets[m_cells[x]];
+            cellSearch(label.previous, x, cellWeights, cellPrevious);
+
+            // The nodes between, in the reverse order.
+            for (auto i = cellPrevious[m_positions[x]]; m_cellNodes[first + i] != label.previous;
+                 i = cellPrevious[i]) {
+                path.emplace_back(m_nodes.node(m_cellNodes[first + i]));
+            }
+        }
+    }
+
+    m_labels.release(std::move(workspace));
+
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+template<typename NodeType, typename WeightType>
+void Overlay<NodeType, WeightType>::partition(std::vector<size_t>::iterator first,
+                                              std::vector<size_t>::iterator last,
+                                              const std::vector<std::pair<double, double>> &points,
+                                              size_t maxCellSize)
+{
+    const auto count = static_cast<size_t>(last - first);
+
+    if (count <= maxCellSize) {
+        if (count == 0) {
+            return;
+        }
+
+        const auto cell = cellCount();
+        for (auto it = first; it != last; ++it) {
+            m_cells[*it] = cell;
+            m_positions[*it] = it - first;
+        }
+        m_cellOffsets.emplace_back(m_cellOffsets.back() + count);
+        return;
+    }
+
+    // The principal axis of the nodes' coordinates.
+    double meanX{}, meanY{};
+    for (auto it = first; it != last; ++it) {
+        meanX += points[*it].first;
+        meanY += points[*it].second;
+    }
+    meanX /= count;
+    meanY /= count;
+
+    double xx{}, yy{}, xy{};
+    for (auto it = first; it != last; ++it) {
+        const auto dx = points[*it].first - meanX;
+        const auto dy = points[*it].second - meanY;
+        xx += dx * dx;
+        yy += dy * dy;
+        xy += dx * dy;
+    }
+
+    const auto angle = 0.5 * std::atan2(2.0 * xy, xx - yy);
+    const auto axisX = std::cos(angle);
+    const auto axisY = std::sin(angle);
+
+    // Cut across the axis in halves.
+    auto middle = first + count / 2;
+    std::nth_element(first, middle, last, [&](size_t x, size_t y) {
+        return points[x].first * axisX + points[x].second * axisY <
+               points[y].first * axisX + points[y].second * axisY;
+    });
+
+    partition(first, middle, points, maxCellSize);
+    partition(middle, last, points, maxCellSize);
+}
+
+template<typename NodeType, typename WeightType>
+void Overlay<NodeType, WeightType>::updateClique(size_t cell, std::vector<WeightType> &weights,
+                                                 std::vector<size_t> &previous)
+{
+    const auto first = m_boundaryOffsets[cell];
+    const auto size = m_boundaryOffsets[cell + 1] - first;
+    auto clique = m_cliques.begin() + m_cliqueOffsets[cell];
+
+    for (size_t i = 0; i < size; ++i) {
+        cellSearch(m_boundaryNodes[first + i], npos, weights, previous);
+
+        for (size_t j = 0; j < size; ++j) {
+            clique[i * size + j] = weights[m_positions[m_boundaryNodes[first + j]]];
+        }
+    }
+}
+
+template<typename NodeType, typename WeightType>
+void Overlay<NodeType, WeightType>::cellSearch(size_t source, size_t target,
+                                               std::vector<WeightType> &weights,
+                                               std::vector<size_t> &previous) const
+{
+    const auto cell = m_cells[source];
+    const auto first = m_cellOffsets[cell];
+    const auto size = m_cellOffsets[cell + 1] - first;
+
+    weights.assign(size, infinity());
+    previous.assign(size, npos);
+
+    Queue queue;
+    weights[m_positions[source]] = WeightType{};
+    queue.push({ WeightType{}, m_positions[source] });
+
+    while (!queue.empty()) {
+        const auto [weight, i] = queue.top();
+        queue.pop();
+
+        if (weights[i] < weight) {
+            continue;
+        }
+
+        const auto x = m_cellNodes[first + i];
+        if (x == target) {
+            break;
+        }
+
+        for (auto e = m_edges.begin(x); e < m_edges.end(x); ++e) {
+            const auto y = m_edges.head(e);
+            if (m_cells[y] != cell) {
+                continue;
+            }
+
+            const auto j = m_positions[y];
+            const auto total = weight + m_weights[e];
+            if (total < weights[j]) {
+                weights[j] = total;
+                previous[j] = i;
+                queue.push({ total, j });
+            }
+        }
+    }
+}
+
+#endif // !__OVERLAY_H__
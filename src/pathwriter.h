@@ -0,0 +1,314 @@
+/**********************************************************************************
+*  MIT License                                                                    *
+*                                                                                 *
+*  Copyright (c) 2023 Vahan Aghajanyan <vahancho@gmail.com>                       *
+*                                                                                 *
+*  Permission is hereby granted, free of charge, to any person obtaining a copy   *
+*  of this software and associated documentation files (the "Software"), to deal  *
+*  in the Software without restriction, including without limitation the rights   *
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+*  copies of the Software, and to permit persons to whom the Software is          *
+*  furnished to do so, subject to the following conditions:                       *
+*                                                                                 *
+*  The above copyright notice and this permission notice shall be included in all *
+*  copies or substantial portions of the Software.                                *
+*                                                                                 *
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+*  SOFTWARE.                                                                      *
+***********************************************************************************/
+
+
+#ifndef __PATHWRITER_H__
+#define __PATHWRITER_H__
+
+#include <atomic>
+#include <charconv>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//! Implements a buffered writer of paths into KML or GeoJSON files.
+/*!
+    The paths are formatted with `std::to_chars` into a large memory buffer
+    that is written to the file when it is full. Optionally, the buffers are
+    written by a background thread, so that the path search and formatting
+    are not blocked by the file I/O.
+*/
+class PathWriter
+{
+public:
+    enum class Format
+    {
+        Kml,
+        GeoJson
+    };
+
+    /// Opens the file for writing.
+    /*!
+        \param filePath The output file path
+        \param format The output file format
+        \param background Whether to write the file by a background thread
+        \param bufferSize The size of the buffer that is written to the file at once
+    */
+    PathWriter(const std::string &filePath, Format format, bool background = false,
+               size_t bufferSize = 1 << 20);
+
+    /// Completes the document and closes the file.
+    ~PathWriter();
+
+    PathWriter(const PathWriter &) = delete;
+    PathWriter &operator=(const PathWriter &) = delete;
+
+    /// Returns true if the file is open and there were no write errors.
+    explicit operator bool() const;
+
+    /// Returns the number of written paths.
+    size_t pathCount() const;
+
+    /// Adds a path (e.g. a LineString) to the file.
+    /*!
+        \param path A container of nodes
+        \param coordinates A function that returns the (lon, lat) coordinates of a node
+    */
+    template<typename Container, typename Coordinates>
+    void addPath(const Container &path, Coordinates coordinates);
+
+private:
+    template<typename T>
+    void append(T value);
+
+    void append(const char *text);
+
+    /// Writes the buffer to the file or hands it over to the background thread.
+    void flush();
+
+    /// The background thread's loop.
+    void run();
+
+    std::ofstream m_file;
+    Format m_format;
+    size_t m_bufferSize;
+    size_t m_pathCount{};
+    std::string m_buffer;
+    std::atomic<bool> m_good{ false };
+
+    /// The maximum number of the buffers waiting for the background writer.
+    static constexpr size_t maxPendingBuffers = 4;
+
+    /// The background writer's state.
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<std::string> m_pending;
+    std::vector<std::string> m_free;
+    bool m_done{ false };
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Definition of the functions
+
+inline PathWriter::PathWriter(const std::string &filePath, Format format, bool background,
+                              size_t bufferSize)
+    :
+        m_file(filePath, std::ios::binary),
+        m_format(format),
+        m_bufferSize(bufferSize)
+{
+    m_good = bool(m_file);
+    if (!m_good) {
+        return;
+    }
+
+    m_buffer.reserve(m_bufferSize + m_bufferSize / 4);
+
+    if (m_format == Format::Kml) {
+        append("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+               "<kml xmlns=\"http://www.opengis.net/kml/2.2\">\n"
+               "  <Document>\n"
+               "    <name>Paths</name>\n"
+               "      <Style id=\"redPoly\">\n"
+               "        <LineStyle>\n"
+               "          <color>ff0000ff</color>\n"
+               "          <width>0.5</width>\n"
+               "        </LineStyle>\n"
+               "      </Style>\n");
+    } else {
+        append("{\"type\":\"FeatureCollection\",\"features\":[\n");
+    }
+
+    if (background) {
+        m_thread = std::thread(&PathWriter::run, this);
+    }
+}
+
+inline PathWriter::~PathWriter()
+{
+    if (m_file.is_open()) {
+        if (m_format == Format::Kml) {
+            append("  </Document>\n"
+                   "</kml>");
+        } else {
+            append("\n]}\n");
+        }
+        flush();
+    }
+
+    if (m_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_done = true;
+        }
+        m_condition.notify_all();
+        m_thread.join();
+    }
+}
+
+inline PathWriter::operator bool() const
+{
+    return m_good;
+}
+
+inline size_t PathWriter::pathCount() const
+{
+    return m_pathCount;
+}
+
+template<typename Container, typename Coordinates>
+void PathWriter::addPath(const Container &path, Coordinates coordinates)
+{
+    if (!m_good) {
+        return;
+    }
+
+    const auto id = m_pathCount++;
+
+    if (m_format == Format::Kml) {
+        append("    <Placemark>\n"
+               "      <name>Route ");
+        append(id);
+        append("</name>\n"
+               "      <styleUrl>#redPoly</styleUrl>\n"
+               "      <LineString>\n"
+               "        <coordinates>\n");
+
+        for (auto && node : path) {
+            const auto [lon, lat] = coordinates(node);
+            append(lon);
+            m_buffer += ',';
+            append(lat);
+            append(",0\n");
+        }
+
+        append("        </coordinates>\n"
+               "      </LineString>\n"
+               "    </Placemark>\n");
+    } else {
+        if (id > 0) {
+            append(",\n");
+        }
+        append("{\"type\":\"Feature\",\"properties\":{\"name\":\"Route ");
+        append(id);
+        append("\"},\"geometry\":{\"type\":\"LineString\",\"coordinates\":[");
+
+        bool first = true;
+        for (auto && node : path) {
+            const auto [lon, lat] = coordinates(node);
+            if (!first) {
+                m_buffer += ',';
+            }
+            first = false;
+
+            m_buffer += '[';
+            append(lon);
+            m_buffer += ',';
+            append(lat);
+            m_buffer += ']';
+        }
+
+        append("]}}");
+    }
+
+    if (m_buffer.size() >= m_bufferSize) {
+        flush();
+    }
+}
+
+template<typename T>
+void PathWriter::append(T value)
+{
+    char chars[32];
+    const auto result = std::to_chars(chars, chars + sizeof(chars), value);
+    m_buffer.append(chars, result.ptr);
+}
+
+inline void PathWriter::append(const char *text)
+{
+    m_buffer += text;
+}
+
+inline void PathWriter::flush()
+{
+    if (m_buffer.empty()) {
+        return;
+    }
+
+    if (!m_thread.joinable()) {
+        m_file.write(m_buffer.data(), m_buffer.size());
+        m_good = m_good && bool(m_file);
+        m_buffer.clear();
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    // Don't let the pending buffers grow unbounded if the writer can't keep up.
+    m_condition.wait(lock, [this] { return m_pending.size() < maxPendingBuffers; });
+    m_pending.emplace_back(std::move(m_buffer));
+
+    if (!m_free.empty()) {
+        m_buffer = std::move(m_free.back());
+        m_free.pop_back();
+    } else {
+        m_buffer = std::string{};
+        m_buffer.reserve(m_bufferSize + m_bufferSize / 4);
+    }
+
+    lock.unlock();
+    m_condition.notify_all();
+}
+
+inline void PathWriter::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (true) {
+        m_condition.wait(lock, [this] { return m_done || !m_pending.empty(); });
+        if (m_pending.empty()) {
+            // Done and nothing left to write.
+            break;
+        }
+
+        auto buffer = std::move(m_pending.front());
+        m_pending.pop_front();
+        lock.unlock();
+        m_condition.notify_all();
+
+        m_file.write(buffer.data(), buffer.size());
+        m_good = m_good && bool(m_file);
+        buffer.clear();
+
+        lock.lock();
+        m_free.emplace_back(std::move(buffer));
+    }
+}
+
+#endif // !__PATHWRITER_H__
@@ -0,0 +1,313 @@
+/**********************************************************************************
+*  MIT License                                                                    *
+*                                                                                 *
+*  Copyright (c) 2023 Vahan Aghajanyan <vahancho@gmail.com>                       *
+*                                                                                 *
+*  Permission is hereby granted, free of charge, to any person obtaining a copy   *
+*  of this software and associated documentation files (the "Software"), to deal  *
+*  in the Software without restriction, including without limitation the rights   *
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+*  copies of the Software, and to permit persons to whom the Software is          *
+*  furnished to do so, subject to the following conditions:                       *
+*                                                                                 *
+*  The above copyright notice and this permission notice shall be included in all *
+*  copies or substantial portions of the Software.                                *
+*                                                                                 *
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+*  SOFTWARE.                                                                      *
+***********************************************************************************/
+
+
+#ifndef __SPATIALINDEX_H__
+#define __SPATIALINDEX_H__
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+//! Implements a uniform grid index over the graph nodes' coordinates.
+/*!
+    The index is built once and answers the nearest node queries, so that
+    arbitrary points (e.g. GPS positions) can be snapped to the graph. The
+    distance is measured in the coordinates' space (Euclidean), so the
+    coordinates must be planar. Raw longitude and latitude are not: a degree
+    of longitude shrinks with cos(latitude), e.g. to 0.59 of a degree of
+    latitude at 53.5 degrees north. Project geodetic coordinates first, for
+    instance with the equirectangular projection (lon * cos(lat0), lat) around
+    the area's latitude lat0, and project the query points the same way.
+*/
+template<typename NodeType>
+class SpatialIndex
+{
+public:
+    using Point = std::pair<double, double>;
+
+    /// Builds the index over all nodes of the \p graph.
+    /*!
+        \param graph The graph to index
+        \param coordinates A function that returns the (x, y) coordinates of a node
+    */
+    template<typename Graph, typename Accessor>
+    SpatialIndex(const Graph &graph, Accessor coordinates);
+
+    /// Returns true if there are no nodes in the index.
+    bool empty() const;
+
+    /// Returns the number of indexed nodes.
+    size_t size() const;
+
+    /// Returns the node nearest to the given \p point or nothing if the index is empty.
+    std::optional<NodeType> nearest(const Point &point) const;
+
+    /// Returns up to \p k nodes nearest to the given \p point ordered by the distance.
+    std::vector<NodeType> nearest(const Point &point, size_t k) const;
+
+    /// Returns the nearest nodes for each of the given \p points.
+    /*!
+        The points are processed in the grid cells order to keep the memory
+        access local, but the results are in the order of the input points.
+    */
+    std::vector<std::optional<NodeType>> snap(const std::vector<Point> &points) const;
+
+private:
+    size_t column(double x) const;
+    size_t row(double y) const;
+
+    double m_minX{};
+    double m_minY{};
+    double m_cellSize{ 1.0 };
+    size_t m_columns{};
+    size_t m_rows{};
+
+    /// The first entry of each cell (plus the end of the last one).
+    std::vector<size_t> m_cellStart;
+
+    /// The nodes and their coordinates sorted by cells.
+    std::vector<double> m_xs;
+    std::vector<double> m_ys;
+    std::vector<NodeType> m_nodes;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Definition of the function templates
+template<typename NodeType>
+template<typename Graph, typename Accessor>
+SpatialIndex<NodeType>::SpatialIndex(const Graph &graph, Accessor coordinates)
+{
+    std::vector<NodeType> nodes;
+    std::vector<Point> points;
+
+    graph.forEachNode([&](const NodeType &node) {
+        nodes.emplace_back(node);
+        points.emplace_back(coordinates(node));
+    });
+
+    if (nodes.empty()) {
+        return;
+    }
+
+    auto maxX = points.front().first;
+    auto maxY = points.front().second;
+    m_minX = maxX;
+    m_minY = maxY;
+
+    for (const auto &point : points) {
+        m_minX = std::min(m_minX, point.first);
+        m_minY = std::min(m_minY, point.second);
+        maxX = std::max(maxX, point.first);
+        maxY = std::max(maxY, point.second);
+    }
+
+    // About two nodes per cell on average.
+    const auto cellsPerSide = std::max(1.0, std::ceil(std::sqrt(nodes.size() / 2.0)));
+    m_cellSize = std::max(maxX - m_minX, maxY - m_minY) / cellsPerSide;
+    if (!(m_cellSize > 0.0)) {
+        m_cellSize = 1.0;
+    }
+
+    m_columns = static_cast<size_t>((maxX - m_minX) / m_cellSize) + 1;
+    m_rows = static_cast<size_t>((maxY - m_minY) / m_cellSize) + 1;
+
+    // Counting sort of the nodes by their cells.
+    std::vector<size_t> cells(nodes.size());
+    m_cellStart.assign(m_columns * m_rows + 1, 0);
+
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        cells[i] = row(points[i].second) * m_columns + column(points[i].first);
+        ++m_cellStart[cells[i] + 1];
+    }
+
+    for (size_t i = 1; i < m_cellStart.size(); ++i) {
+        m_cellStart[i] += m_cellStart[i - 1];
+    }
+
+    auto next = m_cellStart;
+    std::vector<size_t> order(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        order[next[cells[i]]++] = i;
+    }
+
+    m_xs.reserve(nodes.size());
+    m_ys.reserve(nodes.size());
+    m_nodes.reserve(nodes.size());
+
+    for (auto i : order) {
+        m_xs.emplace_back(points[i].first);
+        m_ys.emplace_back(points[i].second);
+        m_nodes.emplace_back(std::move(nodes[i]));
+    }
+}
+
+template<typename NodeType>
+bool SpatialIndex<NodeType>::empty() const
+{
+    return m_nodes.empty();
+}
+
+template<typename NodeType>
+size_t SpatialIndex<NodeType>::size() const
+{
+    return m_nodes.size();
+}
+
+template<typename NodeType>
+size_t SpatialIndex<NodeType>::column(double x) const
+{
+    const auto c = std::clamp((x - m_minX) / m_cellSize, 0.0, double(m_columns - 1));
+    return static_cast<size_t>(c);
+}
+
+template<typename NodeType>
+size_t SpatialIndex<NodeType>::row(double y) const
+{
+    const auto r = std::clamp((y - m_minY) / m_cellSize, 0.0, double(m_rows - 1));
+    return static_cast<size_t>(r);
+}
+
+template<typename NodeType>
+std::optional<NodeType> SpatialIndex<NodeType>::nearest(const Point &point) const
+{
+    auto nodes = nearest(point, 1);
+    if (nodes.empty()) {
+        return std::nullopt;
+    }
+    return std::move(nodes.front());
+}
+
+template<typename NodeType>
+std::vector<NodeType> SpatialIndex<NodeType>::nearest(const Point &point, size_t k) const
+{
+    std::vector<NodeType> result;
+    if (k == 0 || empty()) {
+        return result;
+    }
+
+    const auto [x, y] = point;
+    const auto cx = static_cast<long long>(column(x));
+    const auto cy = static_cast<long long>(row(y));
+    const auto columns = static_cast<long long>(m_columns);
+    const auto rows = static_cast<long long>(m_rows);
+
+    // The squared distance and the entry. The farthest candidate is on top.
+    using Candidate = std::pair<double, size_t>;
+    std::priority_queue<Candidate> best;
+
+    auto visitCell = [&](long long c, long long r) {
+        if (c < 0 || c >= columns || r < 0 || r >= rows) {
+            return;
+        }
+        const auto cell = static_cast<size_t>(r * columns + c);
+        for (size_t i = m_cellStart[cell]; i < m_cellStart[cell + 1]; ++i) {
+            const auto dx = m_xs[i] - x;
+            const auto dy = m_ys[i] - y;
+            const auto distance = dx * dx + dy * dy;
+            if (best.size() < k) {
+                best.emplace(distance, i);
+            } else if (distance < best.top().first) {
+                best.pop();
+                best.emplace(distance, i);
+            }
+        }
+    };
+
+    // Visit the rings of cells around the point's cell.
+    for (long long ring = 0; ; ++ring) {
+        for (auto r = cy - ring; r <= cy + ring; ++r) {
+            if (r == cy - ring || r == cy + ring) {
+                for (auto c = cx - ring; c <= cx + ring; ++c) {
+                    visitCell(c, r);
+                }
+            } else {
+                visitCell(cx - ring, r);
+                visitCell(cx + ring, r);
+            }
+        }
+
+        // The distance to the closest not yet visited cell.
+        auto bound = std::numeric_limits<double>::infinity();
+        if (cx - ring > 0) {
+            bound = std::min(bound, x - (m_minX + (cx - ring) * m_cellSize));
+        }
+        if (cx + ring < columns - 1) {
+            bound = std::min(bound, m_minX + (cx + ring + 1) * m_cellSize - x);
+        }
+        if (cy - ring > 0) {
+            bound = std::min(bound, y - (m_minY + (cy - ring) * m_cellSize));
+        }
+        if (cy + ring < rows - 1) {
+            bound = std::min(bound, m_minY + (cy + ring + 1) * m_cellSize - y);
+        }
+
+        if (bound == std::numeric_limits<double>::infinity()) {
+            // All cells are visited.
+            break;
+        }
+
+        bound = std::max(bound, 0.0);
+        if (best.size() == k && best.top().first <= bound * bound) {
+            break;
+        }
+    }
+
+    result.resize(best.size(), m_nodes[best.top().second]);
+    for (auto i = best.size(); i > 0; --i) {
+        result[i - 1] = m_nodes[best.top().second];
+        best.pop();
+    }
+
+    return result;
+}
+
+template<typename NodeType>
+std::vector<std::optional<NodeType>>
+SpatialIndex<NodeType>::snap(const std::vector<Point> &points) const
+{
+    std::vector<std::optional<NodeType>> result(points.size());
+    if (empty()) {
+        return result;
+    }
+
+    std::vector<std::pair<size_t, size_t>> order; // cell, point
+    order.reserve(points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        order.emplace_back(row(points[i].second) * m_columns + column(points[i].first), i);
+    }
+    std::sort(order.begin(), order.end());
+
+    for (const auto &entry : order) {
+        result[entry.second] = nearest(points[entry.second]);
+    }
+
+    return result;
+}
+
+#endif // !__SPATIALINDEX_H__
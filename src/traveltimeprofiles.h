@@ -0,0 +1,318 @@
+/**********************************************************************************
+*  MIT License                                                                    *
+*                                                                                 *
+*  Copyright (c) 2023 Vahan Aghajanyan <vahancho@gmail.com>                       *
+*                                                                                 *
+*  Permission is hereby granted, free of charge, to any person obtaining a copy   *
+*  of this software and associated documentation files (the "Software"), to deal  *
+*  in the Software without restriction, including without limitation the rights   *
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+*  copies of the Software, and to permit persons to whom the Software is          *
+*  furnished to do so, subject to the following conditions:                       *
+*                                                                                 *
+*  The above copyright notice and this permission notice shall be included in all *
+*  copies or substantial portions of the Software.                                *
+*                                                                                 *
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+*  SOFTWARE.                                                                      *
+***********************************************************************************/
+
+
+#ifndef __TRAVELTIMEPROFILES_H__
+#define __TRAVELTIMEPROFILES_H__
+
+#include "graphindex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+//! Implements piecewise-linear travel time profiles of the graph edges.
+/*!
+    A profile is a list of breakpoints: the departure time and the travel time
+    along the edge when departing at that time. The travel times between the
+    breakpoints are interpolated linearly. The edges are looked up in the
+    compressed sparse row index of the graph and the breakpoints of all edges
+    are packed into a single array, so that evaluating a profile touches a few
+    flat arrays only.
+
+    The profiles are expected to have the FIFO property: departing later never
+    means arriving earlier. The time-dependent search relies on it to find the
+    earliest arrival with a single Dijkstra pass.
+
+    The object can be used as a travel time function of Graphene::earliestArrivalPath(),
+    which looks up the edges of a node with tile() in constant time per edge.
+*/
+template<typename NodeType>
+class TravelTimeProfiles
+{
+public:
+    /// The profile breakpoint.
+    struct Point
+    {
+        double time{};
+        double travelTime{};
+    };
+
+    /// Creates profiles for the edges of the \p graph.
+    /*!
+        The profiles repeat with the given \p period (e.g. a day), or never if it's zero.
+    */
+    template<typename Graph>
+    explicit TravelTimeProfiles(const Graph &graph, double period = 0.0);
+
+    /// Sets the travel time profile of the edge (\p tile, \p head).
+    /*!
+        The profile of the same size replaces the old one in place.
+
+        \return false if there is no such edge, the profile is empty, the breakpoints'
+                times are not ascending (or out of the period) or the profile violates FIFO.
+    */
+    bool setProfile(const NodeType &tile, const NodeType &head, const std::vector<Point> &points);
+
+    /// Returns the travel time along the edge (\p tile, \p head) departing at the \p time.
+    /*!
+        Returns infinity for the edges without a profile, i.e. they can't be traversed.
+    */
+    double operator()(const NodeType &tile, const NodeType &head, double time) const;
+
+    class Tile;
+
+    /// Returns the travel times along the edges of the \p node as a function of their heads.
+    /*!
+        The \p index is the node's number if it's known, e.g. from the Tile::index()
+        of an edge to the node, or npos. The result is valid as long as the object.
+    */
+    Tile tile(const NodeType &node, size_t index = npos) const;
+
+    /// Returns the number of edges with profiles.
+    size_t size() const;
+
+private:
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+    /// The breakpoints of an edge's profile.
+    struct Profile
+    {
+        size_t first{};
+        size_t count{};
+    };
+
+    /// Returns the travel time along the \p edge departing at the \p time.
+    double travelTime(size_t edge, double time) const;
+
+    /// Removes the replaced breakpoints from the array.
+    void compact();
+
+    double m_period;
+
+    NodeIndex<NodeType> m_nodes;
+    EdgeIndex<> m_edges;
+
+    /// The profile of each edge, empty if not set.
+    std::vector<Profile> m_profiles;
+
+    /// All breakpoints packed together.
+    std::vector<Point> m_points;
+
+    /// The number of edges with profiles.
+    size_t m_size{};
+
+    /// The number of the replaced breakpoints that are still in the array.
+    size_t m_unused{};
+};
+
+//! Implements the travel times along the edges of one node as a function of their heads.
+/*!
+    The edges are looked up with an EdgeCursor, so the heads in ascending order
+    take constant time each.
+*/
+template<typename NodeType>
+class TravelTimeProfiles<NodeType>::Tile
+{
+public:
+    Tile(const TravelTimeProfiles &profiles, size_t tile);
+
+    /// Returns the travel time along the edge to the \p head departing at the \p time.
+    double operator()(const NodeType &head, double time);
+
+    /// Returns the number of the last edge's head or npos if there was no such edge.
+    size_t index() const;
+
+private:
+    const TravelTimeProfiles *m_profiles;
+    EdgeCursor<NodeIndex<NodeType>> m_cursor;
+    size_t m_index{ npos };
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Definition of the function templates
+template<typename NodeType>
+template<typename Graph>
+TravelTimeProfiles<NodeType>::TravelTimeProfiles(const Graph &graph, double period)
+    :
+        m_period(period),
+        m_nodes(graph),
+        m_edges(graph, m_nodes),
+        m_profiles(m_edges.size())
+{}
+
+template<typename NodeType>
+bool TravelTimeProfiles<NodeType>::setProfile(const NodeType &tile, const NodeType &head,
+                                              const std::vector<Point> &points)
+{
+    const auto edge = m_edges.edge(m_nodes.index(tile), m_nodes.index(head));
+    if (edge == EdgeIndex<>::npos || points.empty()) {
+        return false;
+    }
+
+    for (size_t i = 0; i < points.size(); ++i) {
+        const auto &point = points[i];
+        if (point.travelTime < 0.0 || (m_period > 0.0 && (point.time < 0.0 || point.time >= m_period))) {
+            return false;
+        }
+
+        if (i > 0) {
+            const auto &previous = points[i - 1];
+            if (point.time <= previous.time ||
+                point.time + point.travelTime < previous.time + previous.travelTime) {
+                return false;
+            }
+        }
+    }
+
+    // The segment that wraps around the period.
+    if (m_period > 0.0 && points.front().time + m_period + points.front().travelTime <
+                          points.back().time + points.back().travelTime) {
+        return false;
+    }
+
+    auto &profile = m_profiles[edge];
+    if (profile.count == 0) {
+        ++m_size;
+    }
+
+    if (profile.count == points.size()) {
+        std::copy(points.cbegin(), points.cend(), m_points.begin() + profile.first);
+        return true;
+    }
+
+    // The old breakpoints are left unused until there are too many of them.
+    m_unused += profile.count;
+    profile = { m_points.size(), points.size() };
+    m_points.insert(m_points.end(), points.cbegin(), points.cend());
+
+    if (m_unused > m_points.size() / 2) {
+        compact();
+    }
+    return true;
+}
+
+template<typename NodeType>
+double TravelTimeProfiles<NodeType>::operator()(const NodeType &tile, const NodeType &head,
+                                                double time) const
+{
+    return travelTime(m_edges.edge(m_nodes.index(tile), m_nodes.index(head)), time);
+}
+
+template<typename NodeType>
+typename TravelTimeProfiles<NodeType>::Tile
+TravelTimeProfiles<NodeType>::tile(const NodeType &node, size_t index) const
+{
+    return Tile(*this, index == npos ? m_nodes.index(node) : index);
+}
+
+template<typename NodeType>
+size_t TravelTimeProfiles<NodeType>::size() const
+{
+    return m_size;
+}
+
+template<typename NodeType>
+double TravelTimeProfiles<NodeType>::travelTime(size_t edge, double time) const
+{
+    if (edge == EdgeIndex<>::npos || m_profiles[edge].count == 0) {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    const auto first = m_points.cbegin() + m_profiles[edge].first;
+    const auto last = first + m_profiles[edge].count;
+
+    if (m_period > 0.0) {
+        time = std::fmod(time, m_period);
+        if (time < 0.0) {
+            time += m_period;
+        }
+    }
+
+    auto interpolate = [](double t, const Point &p1, double t1, const Point &p2, double t2) {
+        return p1.travelTime + (p2.travelTime - p1.travelTime) * (t - t1) / (t2 - t1);
+    };
+
+    auto next = std::upper_bound(first, last, time, [](double t, const Point &point) {
+        return t < point.time;
+    });
+
+    if (next != first && next != last) {
+        const auto &previous = *(next - 1);
+        return interpolate(time, previous, previous.time, *next, next->time);
+    }
+
+    if (m_period > 0.0 && last - first > 1) {
+        // Between the last and the first breakpoints of the next period.
+        const auto &back = *(last - 1);
+        const auto &front = *first;
+        if (next == first) {
+            time += m_period;
+        }
+        return interpolate(time, back, back.time, front, front.time + m_period);
+    }
+
+    return next == first ? first->travelTime : (last - 1)->travelTime;
+}
+
+template<typename NodeType>
+void TravelTimeProfiles<NodeType>::compact()
+{
+    std::vector<Point> points;
+    points.reserve(m_points.size() - m_unused);
+
+    // The profiles in the order of the edges.
+    for (auto &profile : m_profiles) {
+        const auto first = m_points.cbegin() + profile.first;
+        profile.first = points.size();
+        points.insert(points.end(), first, first + profile.count);
+    }
+
+    m_points = std::move(points);
+    m_unused = 0;
+}
+
+template<typename NodeType>
+TravelTimeProfiles<NodeType>::Tile::Tile(const TravelTimeProfiles &profiles, size_t tile)
+    :
+        m_profiles(&profiles),
+        m_cursor(profiles.m_nodes, profiles.m_edges, tile)
+{}
+
+template<typename NodeType>
+double TravelTimeProfiles<NodeType>::Tile::operator()(const NodeType &head, double time)
+{
+    const auto edge = m_cursor.edge(head);
+    m_index = edge == EdgeIndex<>::npos ? npos : m_profiles->m_edges.head(edge);
+    return m_profiles->travelTime(edge, time);
+}
+
+template<typename NodeType>
+size_t TravelTimeProfiles<NodeType>::Tile::index() const
+{
+    return m_index;
+}
+
+#endif // !__TRAVELTIMEPROFILES_H__
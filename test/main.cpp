@@ -22,10 +22,25 @@
 *  SOFTWARE.                                                                      *
 ***********************************************************************************/
 
+#include "compressedgraph.h"
+#include "geodesy.h"
 #include "graphene.h"
+#include "graphindex.h"
+#include "overlay.h"
+#include "pathwriter.h"
+#include "spatialindex.h"
+#include "traveltimeprofiles.h"
 
 #include <gtest/gtest.h>
 
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory_resource>
+#include <numeric>
+#include <sstream>
+#include <thread>
+
 struct Node
 {
     int m_x;
@@ -82,6 +97,30 @@ TEST(General, AddNode)
     EXPECT_EQ(graph.order(), 2);
 }
 
+TEST(General, MemoryUsage)
+{
+    Graphene<int> graph;
+
+    const auto empty = graph.memoryUsage();
+    EXPECT_EQ(empty.nodes, 0);
+    EXPECT_EQ(empty.total(), sizeof(graph));
+
+    graph.addEdge(1, 2);
+    graph.addEdge(1, 3);
+
+    // Adding the same edge doesn't change the graph.
+    graph.addEdge(1, 2);
+    EXPECT_EQ(graph.size(), 2);
+
+    const auto usage = graph.memoryUsage();
+    EXPECT_EQ(usage.nodes, 3 * sizeof(int));
+    EXPECT_GT(usage.adjacency, empty.adjacency + 5 * sizeof(int));
+    EXPECT_EQ(usage.total(), usage.adjacency + usage.nodes);
+
+    graph.addNode(4);
+    EXPECT_GT(graph.memoryUsage().total(), usage.total());
+}
+
 TEST(General, ComplexNode)
 {
     Graphene<Node> graph;
@@ -99,6 +138,64 @@ TEST(General, ComplexNode)
     EXPECT_EQ(graph.adjacent({1, 1}, {0, 0}), false);
 }
 
+TEST(General, Allocator)
+{
+    // Counts the allocations passed to the upstream resource.
+    class CountingResource : public std::pmr::memory_resource
+    {
+    public:
+        size_t m_allocations{};
+
+    private:
+        void *do_allocate(size_t bytes, size_t alignment) override
+        {
+            ++m_allocations;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void *p, size_t bytes, size_t alignment) override
+        {
+            std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+        {
+            return this == &other;
+        }
+    };
+
+    CountingResource resource;
+
+    {
+        PmrGraphene<int, GraphType::Undirected> graph(&resource);
+        for (int i = 1; i < 100; ++i) {
+            graph.addEdge(int{ i }, i + 1);
+        }
+
+        EXPECT_EQ(graph.size(), 198);
+        EXPECT_EQ(graph.order(), 100);
+
+        // Both the nodes and the neighbours are allocated from the resource.
+        EXPECT_EQ(resource.m_allocations, 100 + 198);
+
+        auto path = graph.shortestPath(1, 100, [](int, int) { return 1; });
+        EXPECT_EQ(path.size(), 100);
+        EXPECT_EQ(resource.m_allocations, 100 + 198);
+    }
+
+    // The graph in an arena.
+    std::pmr::monotonic_buffer_resource arena(1 << 16, &resource);
+    resource.m_allocations = 0;
+    {
+        PmrGraphene<int> graph(&arena);
+        for (int i = 1; i < 100; ++i) {
+            graph.addEdge(int{ i }, i + 1);
+        }
+        EXPECT_EQ(graph.size(), 99);
+        EXPECT_EQ(resource.m_allocations, 1);
+    }
+}
+
 TEST(General, ShortestPath)
 {
     //
@@ -217,6 +314,904 @@ TEST(General, ShortestPaths)
     EXPECT_EQ(paths[6][1], 10);
 }
 
+TEST(General, ShortestPathsBounded)
+{
+    //
+    // 1--2--5--8
+    //  \     \/
+    //   10---6---7
+    //
+    Graphene<int> graph;
+
+    auto weightFunction = [] (int x, int y) -> int {
+        return std::abs(x - y);
+    };
+
+    graph.addEdge(1, 2);
+    graph.addEdge(2, 5);
+    graph.addEdge(5, 6);
+    graph.addEdge(5, 8);
+    graph.addEdge(8, 6);
+    graph.addEdge(1, 10);
+    graph.addEdge(10, 6);
+    graph.addEdge(6, 7);
+
+    EXPECT_EQ(graph.shortestPaths(42, weightFunction, 5).size(), 0);
+
+    // Only the nodes 1, 2, 5 and 6 are within the weight of 5.
+    auto paths = graph.shortestPaths(1, weightFunction, 5);
+    ASSERT_EQ(paths.size(), 4);
+    EXPECT_EQ(paths[0], (Graphene<int>::Path{ 1 }));
+    EXPECT_EQ(paths[1], (Graphene<int>::Path{ 1, 2 }));
+    EXPECT_EQ(paths[2], (Graphene<int>::Path{ 1, 2, 5 }));
+    EXPECT_EQ(paths[3], (Graphene<int>::Path{ 1, 2, 5, 6 }));
+
+    EXPECT_EQ(graph.shortestPaths(1, weightFunction, 100), graph.shortestPaths(1, weightFunction));
+}
+
+TEST(General, ForEachShortestPath)
+{
+    //
+    // 1--2--5--8
+    //  \     \/
+    //   10---6---7
+    //
+    Graphene<int> graph;
+
+    auto weightFunction = [] (int x, int y) -> int {
+        return std::abs(x - y);
+    };
+
+    graph.addEdge(1, 2);
+    graph.addEdge(2, 5);
+    graph.addEdge(5, 6);
+    graph.addEdge(5, 8);
+    graph.addEdge(8, 6);
+    graph.addEdge(1, 10);
+    graph.addEdge(10, 6);
+    graph.addEdge(6, 7);
+
+    // Non existent node
+    size_t count{};
+    graph.forEachShortestPath(42, weightFunction, [&](const auto &) { ++count; });
+    EXPECT_EQ(count, 0);
+
+    // The same paths as shortestPaths() returns, but ordered by weights.
+    Graphene<int>::Paths paths;
+    graph.forEachShortestPath(1, weightFunction, [&](const auto &path) {
+        paths.emplace_back(path);
+    });
+
+    ASSERT_EQ(paths.size(), graph.order());
+    EXPECT_EQ(paths[0], (Graphene<int>::Path{ 1 }));
+    EXPECT_EQ(paths[1], (Graphene<int>::Path{ 1, 2 }));
+    EXPECT_EQ(paths[2], (Graphene<int>::Path{ 1, 2, 5 }));
+    EXPECT_EQ(paths[3], (Graphene<int>::Path{ 1, 2, 5, 6 }));
+    EXPECT_EQ(paths[4], (Graphene<int>::Path{ 1, 2, 5, 6, 7 }));
+    EXPECT_EQ(paths[5], (Graphene<int>::Path{ 1, 2, 5, 8 }));
+    EXPECT_EQ(paths[6], (Graphene<int>::Path{ 1, 10 }));
+
+    auto all = graph.shortestPaths(1, weightFunction);
+    std::sort(paths.begin(), paths.end(), [](const auto &x, const auto &y) {
+        return x.back() < y.back();
+    });
+    EXPECT_EQ(paths, all);
+
+    // Stop the search
+    count = 0;
+    graph.forEachShortestPath(1, weightFunction, [&](const auto &) { return ++count < 3; });
+    EXPECT_EQ(count, 3);
+}
+
+TEST(General, ForEachSettledNode)
+{
+    Graphene<int> graph;
+
+    auto weightFunction = [] (int x, int y) -> int {
+        return std::abs(x - y);
+    };
+
+    graph.addEdge(1, 2);
+    graph.addEdge(2, 5);
+    graph.addEdge(1, 10);
+    graph.addEdge(10, 5);
+
+    std::vector<std::tuple<int, int, int>> nodes;
+    graph.forEachSettledNode(1, weightFunction, [&](int node, int previous, int weight) {
+        nodes.emplace_back(node, previous, weight);
+    });
+
+    ASSERT_EQ(nodes.size(), 4);
+    EXPECT_EQ(nodes[0], std::make_tuple(1, 1, 0));
+    EXPECT_EQ(nodes[1], std::make_tuple(2, 1, 1));
+    EXPECT_EQ(nodes[2], std::make_tuple(5, 2, 4));
+    EXPECT_EQ(nodes[3], std::make_tuple(10, 1, 9));
+}
+
+TEST(General, TravelTimeProfiles)
+{
+    Graphene<int> graph;
+    graph.addEdge(1, 2);
+    graph.addEdge(2, 3);
+
+    TravelTimeProfiles<int> profiles(graph);
+
+    EXPECT_FALSE(profiles.setProfile(1, 3, { { 0.0, 1.0 } }));
+    EXPECT_FALSE(profiles.setProfile(1, 42, { { 0.0, 1.0 } }));
+    EXPECT_FALSE(profiles.setProfile(1, 2, {}));
+    EXPECT_FALSE(profiles.setProfile(1, 2, { { 2.0, 1.0 }, { 1.0, 1.0 } }));
+    // Departing at 2 arrives earlier than departing at 1.
+    EXPECT_FALSE(profiles.setProfile(1, 2, { { 1.0, 5.0 }, { 2.0, 1.0 } }));
+    EXPECT_EQ(profiles.size(), 0);
+
+    EXPECT_TRUE(profiles.setProfile(1, 2, { { 7.0, 1.0 }, { 8.0, 3.0 }, { 9.0, 2.5 } }));
+    EXPECT_EQ(profiles.size(), 1);
+    EXPECT_EQ(profiles(1, 2, 0.0), 1.0);
+    EXPECT_EQ(profiles(1, 2, 7.5), 2.0);
+    EXPECT_EQ(profiles(1, 2, 8.0), 3.0);
+    EXPECT_EQ(profiles(1, 2, 8.5), 2.75);
+    EXPECT_EQ(profiles(1, 2, 10.0), 2.5);
+    EXPECT_EQ(profiles(2, 1, 8.0), std::numeric_limits<double>::infinity());
+    EXPECT_EQ(profiles(2, 3, 8.0), std::numeric_limits<double>::infinity());
+    EXPECT_EQ(profiles(42, 1, 8.0), std::numeric_limits<double>::infinity());
+
+    // The edges of a node as the searches look them up.
+    auto tile = profiles.tile(1);
+    EXPECT_EQ(tile(2, 7.5), 2.0);
+    // The number of the node 2.
+    EXPECT_EQ(tile.index(), 1);
+    EXPECT_EQ(tile(3, 7.5), std::numeric_limits<double>::infinity());
+    EXPECT_EQ(profiles.tile(2, 1)(1, 8.0), std::numeric_limits<double>::infinity());
+    EXPECT_EQ(profiles.tile(42)(1, 8.0), std::numeric_limits<double>::infinity());
+
+    // The updates in place and with the new number of breakpoints.
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_TRUE(profiles.setProfile(2, 3, { { 0.0, double(i) } }));
+
+        std::vector<TravelTimeProfiles<int>::Point> points;
+        for (int j = 0; j <= i % 3; ++j) {
+            points.push_back({ double(j), double(i) });
+        }
+        EXPECT_TRUE(profiles.setProfile(1, 2, points));
+    }
+    EXPECT_EQ(profiles.size(), 2);
+    EXPECT_EQ(profiles(2, 3, 8.0), 99.0);
+    EXPECT_EQ(profiles(1, 2, 8.0), 99.0);
+
+    // The daily profile
+    TravelTimeProfiles<int> daily(graph, 24.0);
+    EXPECT_FALSE(daily.setProfile(1, 2, { { 1.0, 1.0 }, { 25.0, 1.0 } }));
+    EXPECT_TRUE(daily.setProfile(1, 2, { { 6.0, 1.0 }, { 18.0, 3.0 } }));
+    EXPECT_EQ(daily(1, 2, 12.0), 2.0);
+    EXPECT_EQ(daily(1, 2, 36.0), 2.0);
+    EXPECT_EQ(daily(1, 2, 0.0), 2.0);
+    EXPECT_EQ(daily(1, 2, 21.0), 2.5);
+}
+
+TEST(General, EarliestArrivalPath)
+{
+    // 1--2--3
+    //  \    |
+    //   `---4
+    Graphene<int> graph;
+    graph.addEdge(1, 2);
+    graph.addEdge(2, 3);
+    graph.addEdge(1, 4);
+    graph.addEdge(4, 3);
+
+    TravelTimeProfiles<int> profiles(graph);
+
+    // The road 1->2 is congested in the rush hour.
+    EXPECT_TRUE(profiles.setProfile(1, 2, { { 7.0, 1.0 }, { 8.0, 10.0 }, { 17.0, 1.0 } }));
+    EXPECT_TRUE(profiles.setProfile(2, 3, { { 0.0, 1.0 } }));
+    EXPECT_TRUE(profiles.setProfile(1, 4, { { 0.0, 3.0 } }));
+
+    // There is no profile for the edge 4->3 yet, so it can't be traversed.
+    EXPECT_EQ(graph.earliestArrivalPath(1, 3, 8.0, std::cref(profiles)), (Graphene<int>::Path{ 1, 2, 3 }));
+
+    EXPECT_TRUE(profiles.setProfile(4, 3, { { 0.0, 3.0 } }));
+
+    EXPECT_EQ(graph.earliestArrivalPath(1, 3, 5.0, profiles), (Graphene<int>::Path{ 1, 2, 3 }));
+    EXPECT_EQ(graph.earliestArrivalPath(1, 3, 8.0, profiles), (Graphene<int>::Path{ 1, 4, 3 }));
+    EXPECT_EQ(graph.earliestArrivalPath(1, 3, 20.0, profiles), (Graphene<int>::Path{ 1, 2, 3 }));
+    EXPECT_EQ(graph.earliestArrivalPath(1, 42, 8.0, profiles).size(), 0);
+
+    // The travel time depends on the arrival time to the edge's tile.
+    Graphene<int> chain;
+    chain.addEdge(1, 2);
+    chain.addEdge(2, 3);
+    chain.addEdge(1, 3);
+
+    auto travelTime = [](int tile, int head, int time) {
+        if (tile == 2 && head == 3) {
+            return time < 10 ? 1 : 100;
+        }
+        return tile == 1 && head == 3 ? 20 : 5;
+    };
+    EXPECT_EQ(chain.earliestArrivalPath(1, 3, 0, travelTime), (Graphene<int>::Path{ 1, 2, 3 }));
+    EXPECT_EQ(chain.earliestArrivalPath(1, 3, 5, travelTime), (Graphene<int>::Path{ 1, 3 }));
+}
+
+TEST(General, NearestSources)
+{
+    //
+    // 1--2--5--8
+    //  \     \/
+    //   10---6---7
+    //
+    Graphene<int, GraphType::Undirected> graph;
+
+    auto weightFunction = [] (int x, int y) -> int {
+        return std::abs(x - y);
+    };
+
+    graph.addEdge(1, 2);
+    graph.addEdge(2, 5);
+    graph.addEdge(5, 6);
+    graph.addEdge(5, 8);
+    graph.addEdge(8, 6);
+    graph.addEdge(1, 10);
+    graph.addEdge(10, 6);
+    graph.addEdge(6, 7);
+    graph.addNode(42);
+
+    EXPECT_EQ(graph.nearestSources(std::vector<int>{}, weightFunction).size(), 0);
+    EXPECT_EQ(graph.nearestSources(std::vector<int>{ 100 }, weightFunction).size(), 0);
+
+    auto nearest = graph.nearestSources(std::vector<int>{ 1, 8, 1000 }, weightFunction);
+
+    // The node 42 isn't reachable.
+    ASSERT_EQ(nearest.size(), 7);
+
+    const std::map<int, std::pair<int, int>> expected =
+    {
+        { 1, { 1, 0 } }, { 2, { 1, 1 } }, { 5, { 8, 3 } }, { 6, { 8, 2 } },
+        { 7, { 8, 3 } }, { 8, { 8, 0 } }, { 10, { 8, 6 } }
+    };
+
+    for (auto && [node, source] : expected) {
+        EXPECT_EQ(nearest.at(node).source, source.first);
+        EXPECT_EQ(nearest.at(node).weight, source.second);
+    }
+}
+
+TEST(General, MinimumSpanningForest)
+{
+    //
+    // 1--2--5   7--8
+    //  \  |
+    //   10-6
+    //
+    Graphene<int, GraphType::Undirected> graph;
+
+    auto weightFunction = [] (int x, int y) -> int {
+        return std::abs(x - y);
+    };
+
+    EXPECT_EQ(graph.minimumSpanningForest(weightFunction).size(), 0);
+
+    graph.addEdge(1, 2);
+    graph.addEdge(2, 5);
+    graph.addEdge(2, 6);
+    graph.addEdge(1, 10);
+    graph.addEdge(10, 6);
+    graph.addEdge(7, 8);
+    graph.addNode(42);
+
+    auto forest = graph.minimumSpanningForest(weightFunction);
+    using Edges = Graphene<int, GraphType::Undirected>::Edges;
+    EXPECT_EQ(forest, (Edges{ { 1, 2 }, { 2, 5 }, { 2, 6 }, { 6, 10 }, { 7, 8 } }));
+}
+
+// Makes a side x side grid with the edges in both directions between the neighbouring nodes.
+template<GraphType GT>
+static Graphene<int, GT> makeGrid(int side)
+{
+    Graphene<int, GT> graph;
+    for (int y = 0; y < side; ++y) {
+        for (int x = 0; x < side; ++x) {
+            const auto node = y * side + x;
+            if (x + 1 < side) {
+                graph.addEdge(int{ node }, node + 1);
+                graph.addEdge(node + 1, int{ node });
+            }
+            if (y + 1 < side) {
+                graph.addEdge(int{ node }, node + side);
+                graph.addEdge(node + side, int{ node });
+            }
+        }
+    }
+    return graph;
+}
+
+// Returns a pseudo random weight in [0, 100] of the edge from x to y.
+static int gridWeight(int x, int y, int seed = 0)
+{
+    return static_cast<int>((x * 7919LL + y * 104729LL + seed) % 101);
+}
+
+TEST(General, MinimumSpanningForestParallel)
+{
+    static constexpr int side = 150;
+    const auto graph = makeGrid<GraphType::Undirected>(side);
+
+    auto weightFunction = [] (int x, int y) -> int {
+        return gridWeight(x, y);
+    };
+
+    // Kruskal's algorithm as a reference.
+    std::vector<std::tuple<int, int, int>> edges;
+    graph.forEachEdge([&](int x, int y) {
+        if (x < y) {
+            edges.emplace_back(weightFunction(x, y), x, y);
+        }
+    });
+    std::sort(edges.begin(), edges.end());
+
+    std::vector<int> parents(side * side);
+    std::iota(parents.begin(), parents.end(), 0);
+    std::function<int(int)> find = [&](int x) {
+        return parents[x] == x ? x : parents[x] = find(parents[x]);
+    };
+
+    long long expected{};
+    for (auto && [w, x, y] : edges) {
+        if (find(x) != find(y)) {
+            parents[find(x)] = find(y);
+            expected += w;
+        }
+    }
+
+    auto total = [&](const auto &forest) {
+        long long result{};
+        for (auto && edge : forest) {
+            result += weightFunction(edge.first, edge.second);
+        }
+        return result;
+    };
+
+    const auto sequential = graph.minimumSpanningForest(weightFunction, 1);
+    const auto parallel = graph.minimumSpanningForest(weightFunction, 4);
+
+    EXPECT_EQ(sequential.size(), side * side - 1);
+    EXPECT_EQ(total(sequential), expected);
+    EXPECT_EQ(parallel, sequential);
+}
+
+TEST(General, CompressedGraph)
+{
+    // A grid with some long range edges for the multibyte differences.
+    static constexpr int side = 60;
+    auto graph = makeGrid<GraphType::Undirected>(side);
+    for (int node = 0; node < side * side; node += 7) {
+        graph.addEdge(int{ node }, (node * 37) % (side * side));
+    }
+    graph.addNode(side * side + 1);
+
+    // A hub for the decoding of many neighbours at once.
+    for (int i = 100; i < 140; ++i) {
+        graph.addEdge(side * side + 2, int{ i });
+    }
+
+    auto weightFunction = [](int x, int y) -> double {
+        return (gridWeight(x, y) + 1) / 10.0;
+    };
+
+    CompressedGraph<int> compressed(graph, weightFunction, 10.0);
+
+    EXPECT_TRUE(compressed);
+    EXPECT_EQ(compressed.order(), graph.order());
+    EXPECT_EQ(compressed.size(), graph.size());
+    EXPECT_EQ(compressed.scale(), 10.0);
+    EXPECT_LT(compressed.memoryUsage() * 4, graph.memoryUsage().total());
+
+    auto pathWeight = [&](const std::vector<int> &path) {
+        double result{};
+        for (size_t i = 1; i < path.size(); ++i) {
+            EXPECT_TRUE(graph.adjacent(path[i - 1], path[i]));
+            result += weightFunction(path[i - 1], path[i]);
+        }
+        return result;
+    };
+
+    for (int from = 0; from < side * side; from += 331) {
+        for (int to = side * side - 1; to >= 0; to -= 313) {
+            const auto path = compressed.shortestPath(from, to);
+            const auto expected = pathWeight(graph.shortestPath(from, to, weightFunction));
+
+            ASSERT_FALSE(path.empty());
+            EXPECT_EQ(path.front(), from);
+            EXPECT_EQ(path.back(), to);
+            EXPECT_NEAR(pathWeight(path), expected, 1e-9);
+            EXPECT_NEAR(compressed.distance(from, to), expected, 1e-9);
+            EXPECT_NEAR(compressed.pathWeight(path), expected, 1e-9);
+        }
+    }
+
+    EXPECT_EQ(compressed.shortestPath(side * side + 2, 139).size(), 2);
+    EXPECT_EQ(compressed.pathWeight({ 0, 2 }), std::numeric_limits<double>::infinity());
+    EXPECT_TRUE(compressed.shortestPath(0, side * side + 1).empty());
+    EXPECT_TRUE(compressed.shortestPath(0, side * side).empty());
+    EXPECT_EQ(compressed.distance(0, side * side + 1), std::numeric_limits<double>::infinity());
+
+    // The node numbers must fit the index type.
+    CompressedGraph<int, uint16_t, uint8_t> narrow(graph, weightFunction, 10.0);
+    EXPECT_FALSE(narrow);
+    EXPECT_EQ(narrow.order(), 0);
+    EXPECT_TRUE(narrow.shortestPath(0, 1).empty());
+
+    CompressedGraph<int, uint16_t, uint64_t> wide(graph, weightFunction, 10.0);
+    EXPECT_TRUE(wide);
+    EXPECT_EQ(wide.shortestPath(0, side * side - 1), compressed.shortestPath(0, side * side - 1));
+
+    // The concurrent queries use their own workspaces.
+    const auto expected = compressed.shortestPath(0, side * side - 1);
+    std::vector<std::thread> threads;
+    std::vector<std::vector<int>> results(4);
+    for (size_t i = 0; i < results.size(); ++i) {
+        threads.emplace_back([&, i]() {
+            for (int j = 0; j < 10; ++j) {
+                results[i] = compressed.shortestPath(0, side * side - 1);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    for (auto &result : results) {
+        EXPECT_EQ(result, expected);
+    }
+
+    // The weights are clamped to the quantized range.
+    CompressedGraph<int, uint8_t> clamped(graph, [](int, int) { return 1000.0; });
+    EXPECT_EQ(clamped.distance(0, 2), 510.0);
+}
+
+TEST(General, GraphIndex)
+{
+    Graphene<int> graph;
+    graph.addEdge(5, 1);
+    graph.addEdge(5, 9);
+    graph.addEdge(1, 9);
+    graph.addNode(3);
+
+    NodeIndex<int, uint32_t> nodes(graph);
+    ASSERT_EQ(nodes.size(), 4);
+    EXPECT_EQ(nodes.index(1), 0);
+    EXPECT_EQ(nodes.index(9), 3);
+    EXPECT_EQ(nodes.index(4), (NodeIndex<int, uint32_t>::npos));
+    EXPECT_EQ(nodes.node(2), 5);
+
+    EdgeIndex<uint32_t> edges(graph, nodes);
+    ASSERT_EQ(edges.size(), 3);
+    EXPECT_EQ(edges.end(nodes.index(3)) - edges.begin(nodes.index(3)), 0);
+    EXPECT_EQ(edges.end(nodes.index(5)) - edges.begin(nodes.index(5)), 2);
+    EXPECT_EQ(edges.heads(nodes.index(5))[1], nodes.index(9));
+    EXPECT_EQ(edges.head(edges.edge(nodes.index(5), nodes.index(1))), nodes.index(1));
+    EXPECT_EQ(edges.edge(nodes.index(1), nodes.index(5)), EdgeIndex<uint32_t>::npos);
+
+    EdgeCursor<NodeIndex<int, uint32_t>, uint32_t> cursor(nodes, edges, nodes.index(5));
+    EXPECT_EQ(cursor.edge(9), edges.edge(nodes.index(5), nodes.index(9)));
+    EXPECT_EQ(cursor.edge(1), edges.edge(nodes.index(5), nodes.index(1)));
+    EXPECT_EQ(cursor.edge(3), EdgeIndex<uint32_t>::npos);
+
+    std::vector<int> visited(10000, 0);
+    parallelFor(visited.size(), 4, 1000, [&](size_t, size_t first, size_t last) {
+        for (auto i = first; i < last; ++i) {
+            ++visited[i];
+        }
+    });
+    EXPECT_EQ(std::count(visited.cbegin(), visited.cend(), 1), visited.size());
+}
+
+TEST(General, Overlay)
+{
+    // A directed grid with different weights in the two directions.
+    static constexpr int side = 40;
+    const auto graph = makeGrid<GraphType::Directed>(side);
+
+    auto coordinates = [](int node) {
+        return std::make_pair(double(node % side), double(node / side));
+    };
+
+    int seed = 1;
+    auto weightFunction = [&seed](int x, int y) -> int {
+        return gridWeight(x, y, seed) + 1;
+    };
+
+    Overlay<int, int> overlay(graph, coordinates, weightFunction, 100, 4);
+
+    EXPECT_EQ(overlay.cellCount(), 16);
+    EXPECT_EQ(overlay.cell(side * side), Overlay<int>::npos);
+    EXPECT_GT(overlay.boundarySize(), 0);
+    EXPECT_LT(overlay.boundarySize(), side * side);
+
+    auto pathWeight = [&](const std::vector<int> &path) {
+        int result{};
+        for (size_t i = 1; i < path.size(); ++i) {
+            EXPECT_TRUE(graph.adjacent(path[i - 1], path[i]));
+            result += weightFunction(path[i - 1], path[i]);
+        }
+        return result;
+    };
+
+    auto check = [&]() {
+        for (int from = 0; from < side * side; from += 197) {
+            for (int to = side * side - 1; to >= 0; to -= 173) {
+                const auto path = overlay.shortestPath(from, to);
+                const auto expected = graph.shortestPath(from, to, weightFunction);
+
+                ASSERT_FALSE(path.empty());
+                EXPECT_EQ(path.front(), from);
+                EXPECT_EQ(path.back(), to);
+                EXPECT_EQ(pathWeight(path), pathWeight(expected));
+            }
+        }
+    };
+
+    check();
+
+    // New weights, cell by cell.
+    seed = 50;
+    for (size_t cell = 0; cell < overlay.cellCount(); ++cell) {
+        overlay.updateCell(cell, weightFunction);
+    }
+
+    check();
+
+    EXPECT_EQ(overlay.shortestPath(0, 0), std::vector<int>{ 0 });
+    EXPECT_TRUE(overlay.shortestPath(0, side * side).empty());
+
+    // The concurrent queries use their own workspaces.
+    const auto expected = overlay.shortestPath(0, side * side - 1);
+    std::vector<std::thread> threads;
+    std::vector<std::vector<int>> results(4);
+    for (size_t i = 0; i < results.size(); ++i) {
+        threads.emplace_back([&, i]() {
+            for (int j = 0; j < 10; ++j) {
+                results[i] = overlay.shortestPath(0, side * side - 1);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    for (auto &result : results) {
+        EXPECT_EQ(result, expected);
+    }
+}
+
+TEST(General, ShortestPathMaxWeight)
+{
+    //
+    // 1--2--5--8
+    //  \     \/
+    //   10---6---7
+    //
+    Graphene<int> graph;
+
+    auto weightFunction = [] (int x, int y) -> int {
+        return std::abs(x - y);
+    };
+
+    graph.addEdge(1, 2);
+    graph.addEdge(2, 5);
+    graph.addEdge(5, 6);
+    graph.addEdge(5, 8);
+    graph.addEdge(8, 6);
+    graph.addEdge(1, 10);
+    graph.addEdge(10, 6);
+    graph.addEdge(6, 7);
+
+    EXPECT_EQ(graph.shortestPath(1, 7, weightFunction, 6), (Graphene<int>::Path{ 1, 2, 5, 6, 7 }));
+    EXPECT_TRUE(graph.shortestPath(1, 7, weightFunction, 5).empty());
+    EXPECT_EQ(graph.shortestPath(1, 1, weightFunction, 0), (Graphene<int>::Path{ 1 }));
+    EXPECT_TRUE(graph.shortestPath(1, 42, weightFunction, 100).empty());
+
+    // The query is abandoned as soon as the weight is exceeded.
+    Graphene<int> line;
+    for (int i = 0; i < 1000; ++i) {
+        line.addEdge(int{ i }, i + 1);
+    }
+
+    size_t calls = 0;
+    auto countingWeight = [&calls] (int, int) -> int {
+        ++calls;
+        return 1;
+    };
+
+    EXPECT_TRUE(line.shortestPath(0, 1000, countingWeight, 10).empty());
+    EXPECT_LE(calls, 11);
+    EXPECT_EQ(line.shortestPath(0, 1000, countingWeight).size(), 1001);
+}
+
+TEST(General, ShortestPathsUndirected)
+{
+    Graphene<int, GraphType::Undirected> graph;
+
+    auto weightFunction = [](int x, int y) -> int {
+        return std::abs(x - y);
+    };
+
+    graph.addEdge(1, 2);
+    graph.addEdge(2, 3);
+
+    auto paths = graph.shortestPaths(1, weightFunction);
+    EXPECT_EQ(paths.size(), 3);
+
+    // The source node is never reached again through its neighbours.
+    EXPECT_EQ(paths[0].size(), 1);
+    EXPECT_EQ(paths[0][0], 1);
+    EXPECT_EQ(paths[2].size(), 3);
+}
+
+TEST(General, KShortestPaths)
+{
+    // The Yen's algorithm example graph: C=1, D=2, E=3, F=4, G=5, H=6
+    Graphene<int> graph;
+    std::map<std::pair<int, int>, int> weights =
+    {
+        {{1, 2}, 3}, {{1, 3}, 2}, {{2, 4}, 4}, {{3, 2}, 1}, {{3, 4}, 2},
+        {{3, 5}, 3}, {{4, 5}, 2}, {{4, 6}, 1}, {{5, 6}, 2}
+    };
+
+    for (auto && edge : weights) {
+        graph.addEdge(edge.first.first, edge.first.second);
+    }
+
+    auto weightFunction = [&](int x, int y) -> int {
+        return weights.at({ x, y });
+    };
+
+    // Non existent nodes
+    EXPECT_EQ(graph.kShortestPaths(1, 42, 3, weightFunction).size(), 0);
+    EXPECT_EQ(graph.kShortestPaths(1, 6, 0, weightFunction).size(), 0);
+
+    auto paths = graph.kShortestPaths(1, 6, 3, weightFunction);
+    ASSERT_EQ(paths.size(), 3);
+    EXPECT_EQ(paths[0], (Graphene<int>::Path{ 1, 3, 4, 6 }));
+    EXPECT_EQ(paths[1], (Graphene<int>::Path{ 1, 3, 5, 6 }));
+    EXPECT_EQ(paths[2], (Graphene<int>::Path{ 1, 2, 4, 6 }));
+
+    // There are only seven loopless paths between the nodes.
+    paths = graph.kShortestPaths(1, 6, 10, weightFunction);
+    ASSERT_EQ(paths.size(), 7);
+    EXPECT_EQ(paths[3], (Graphene<int>::Path{ 1, 3, 2, 4, 6 }));
+    EXPECT_EQ(paths[4], (Graphene<int>::Path{ 1, 3, 4, 5, 6 }));
+    EXPECT_EQ(paths[5], (Graphene<int>::Path{ 1, 2, 4, 5, 6 }));
+    EXPECT_EQ(paths[6], (Graphene<int>::Path{ 1, 3, 2, 4, 5, 6 }));
+}
+
+TEST(General, KShortestPathsParallel)
+{
+    static constexpr int side = 20;
+    const auto graph = makeGrid<GraphType::Undirected>(side);
+
+    // Not thread safe: the weights are taken once before the parallel searches.
+    size_t calls = 0;
+    auto weightFunction = [&](int x, int y) {
+        ++calls;
+        return gridWeight(x, y);
+    };
+
+    const auto expected = graph.kShortestPaths(0, side * side - 1, 10, weightFunction, 1);
+    ASSERT_EQ(expected.size(), 10);
+    EXPECT_EQ(calls, graph.size());
+
+    auto pathWeight = [](const auto &path) {
+        int weight = 0;
+        for (size_t i = 1; i < path.size(); ++i) {
+            weight += gridWeight(path[i - 1], path[i]);
+        }
+        return weight;
+    };
+
+    for (size_t i = 1; i < expected.size(); ++i) {
+        EXPECT_LE(pathWeight(expected[i - 1]), pathWeight(expected[i]));
+    }
+
+    calls = 0;
+    EXPECT_EQ(graph.kShortestPaths(0, side * side - 1, 10, weightFunction, 4), expected);
+    EXPECT_EQ(calls, graph.size());
+}
+
+TEST(General, SpatialIndex)
+{
+    // A 10x10 grid of nodes: node = y * 10 + x
+    Graphene<int> graph;
+    for (int i = 0; i < 100; ++i) {
+        graph.addNode(i);
+    }
+
+    auto coordinates = [](int node) {
+        return std::make_pair(double(node % 10), double(node / 10));
+    };
+
+    SpatialIndex<int> empty(Graphene<int>{}, coordinates);
+    EXPECT_TRUE(empty.empty());
+    EXPECT_FALSE(empty.nearest({ 0.0, 0.0 }).has_value());
+    EXPECT_EQ(empty.nearest({ 0.0, 0.0 }, 3).size(), 0);
+
+    SpatialIndex<int> index(graph, coordinates);
+    EXPECT_EQ(index.size(), 100);
+
+    EXPECT_EQ(index.nearest({ 0.0, 0.0 }).value(), 0);
+    EXPECT_EQ(index.nearest({ 3.2, 4.9 }).value(), 53);
+    EXPECT_EQ(index.nearest({ 8.6, 8.6 }).value(), 99);
+
+    // Points outside of the indexed area
+    EXPECT_EQ(index.nearest({ -100.0, 4.1 }).value(), 40);
+    EXPECT_EQ(index.nearest({ 20.0, 20.0 }).value(), 99);
+
+    auto nodes = index.nearest({ 5.2, 4.9 }, 3);
+    ASSERT_EQ(nodes.size(), 3);
+    EXPECT_EQ(nodes[0], 55);
+    EXPECT_EQ(nodes[1], 56);
+    EXPECT_EQ(nodes[2], 45);
+
+    EXPECT_EQ(index.nearest({ 5.0, 5.0 }, 1000).size(), 100);
+
+    auto snapped = index.snap({ { 9.0, 0.0 }, { 0.1, 0.2 }, { 4.4, 7.6 } });
+    ASSERT_EQ(snapped.size(), 3);
+    EXPECT_EQ(snapped[0].value(), 9);
+    EXPECT_EQ(snapped[1].value(), 0);
+    EXPECT_EQ(snapped[2].value(), 84);
+}
+
+TEST(General, Geodesy)
+{
+    // Nodes along a parallel with 0.01 degree step in longitude: node = index
+    Graphene<int> graph;
+    for (int i = 0; i < 100; ++i) {
+        graph.addEdge(int{ i }, i + 1);
+    }
+    graph.addEdge(0, 100);
+
+    auto coordinates = [](int node) {
+        return std::make_pair(10.0 + node * 0.01, 53.5);
+    };
+
+    auto reference = [&](int x, int y) {
+        const auto radians = 3.14159265358979323846 / 180.0;
+        const auto [lon1, lat1] = coordinates(x);
+        const auto [lon2, lat2] = coordinates(y);
+        const auto a = std::pow(std::sin((lat2 - lat1) * radians / 2.0), 2) +
+                       std::cos(lat1 * radians) * std::cos(lat2 * radians) *
+                       std::pow(std::sin((lon2 - lon1) * radians / 2.0), 2);
+        return 6371e3 * 2.0 * std::atan2(std::sqrt(a), std::sqrt(1.0 - a));
+    };
+
+    GeoNodes<int> nodes(graph, coordinates);
+    EXPECT_EQ(nodes.size(), 101);
+    EXPECT_EQ(nodes.index(42), 42);
+    EXPECT_EQ(nodes.index(-1), nodes.size());
+    EXPECT_EQ(nodes.node(42), 42);
+
+    EXPECT_NEAR(nodes.distance(0, 1), reference(0, 1), 1e-6);
+    EXPECT_NEAR(nodes.distance(3, 77), reference(3, 77), 1e-6);
+    EXPECT_EQ(nodes.distance(0, 1000), std::numeric_limits<double>::infinity());
+
+    std::vector<size_t> targets(100);
+    std::iota(targets.begin(), targets.end(), 1);
+    std::vector<double> distances(targets.size());
+    nodes.distances(0, targets.data(), targets.size(), distances.data());
+    for (size_t i = 0; i < targets.size(); ++i) {
+        EXPECT_NEAR(distances[i], reference(0, int(targets[i])), 1e-6);
+    }
+
+    // The path is longer than a single batch.
+    Graphene<int>::Path path(101);
+    std::iota(path.begin(), path.end(), 0);
+    double length{};
+    for (size_t i = 1; i < path.size(); ++i) {
+        length += reference(path[i - 1], path[i]);
+    }
+    EXPECT_NEAR(nodes.pathLength(path), length, 1e-6);
+    EXPECT_EQ(nodes.pathLength(Graphene<int>::Path{ 1 }), 0.0);
+    EXPECT_EQ(nodes.pathLength(Graphene<int>::Path{ 1, 1000 }), std::numeric_limits<double>::infinity());
+
+    GeoEdgeWeights<int> weights(graph, nodes);
+    EXPECT_EQ(weights.size(), graph.size());
+    EXPECT_NEAR(weights(5, 6), reference(5, 6), 1e-6);
+    EXPECT_NEAR(weights(0, 100), reference(0, 100), 1e-6);
+    EXPECT_EQ(weights(6, 5), std::numeric_limits<double>::infinity());
+
+    // The edges of a node in any order, the heads' numbers are kept for the searches.
+    auto tile = weights.tile(0);
+    EXPECT_NEAR(tile(100), reference(0, 100), 1e-6);
+    EXPECT_EQ(tile.index(), 100);
+    EXPECT_NEAR(tile(1), reference(0, 1), 1e-6);
+    EXPECT_EQ(tile.index(), 1);
+    EXPECT_EQ(tile(2), std::numeric_limits<double>::infinity());
+    EXPECT_NEAR(weights.tile(5, 5)(6), reference(5, 6), 1e-6);
+    EXPECT_EQ(weights.tile(1000)(1), std::numeric_limits<double>::infinity());
+
+    EXPECT_EQ(graph.shortestPath(0, 100, std::cref(weights)), (Graphene<int>::Path{ 0, 100 }));
+
+    // The points all over the globe, including the antipodes, for the whole range of the kernel.
+    Graphene<int> globe;
+    for (int i = 0; i < 360; ++i) {
+        globe.addNode(int{ i });
+    }
+    auto globeCoordinates = [](int node) {
+        return std::make_pair(-180.0 + node, node % 2 ? -89.5 + node / 2 : 89.5 - node / 2);
+    };
+    GeoNodes<int> globeNodes(globe, globeCoordinates);
+
+    std::vector<size_t> all(360);
+    std::iota(all.begin(), all.end(), 0);
+    std::vector<double> globeDistances(all.size());
+
+    for (int from : { 0, 1, 179, 180, 359 }) {
+        globeNodes.distances(from, all.data(), all.size(), globeDistances.data());
+        const auto [lon1, lat1] = globeCoordinates(from);
+
+        for (size_t i = 0; i < all.size(); ++i) {
+            const auto radians = 3.14159265358979323846 / 180.0;
+            const auto [lon2, lat2] = globeCoordinates(int(i));
+            const auto a = std::pow(std::sin((lat2 - lat1) * radians / 2.0), 2) +
+                           std::cos(lat1 * radians) * std::cos(lat2 * radians) *
+                           std::pow(std::sin((lon2 - lon1) * radians / 2.0), 2);
+            const auto expected = 6371e3 * 2.0 * std::asin(std::sqrt(std::min(1.0, a)));
+            EXPECT_NEAR(globeDistances[i], expected, 1e-6);
+        }
+    }
+}
+
+static std::string writePaths(PathWriter::Format format, bool background, size_t bufferSize)
+{
+    const auto filePath = std::filesystem::temp_directory_path() / "graphene_paths.out";
+
+    {
+        PathWriter writer(filePath.string(), format, background, bufferSize);
+        EXPECT_TRUE(writer);
+
+        auto coordinates = [](int node) {
+            return std::make_pair(node * 0.5, -node * 1.25);
+        };
+
+        const std::vector<int> path = { 1, 2 };
+        for (int i = 0; i < 3; ++i) {
+            writer.addPath(path, coordinates);
+        }
+        EXPECT_EQ(writer.pathCount(), 3);
+    }
+
+    std::ifstream file(filePath);
+    std::stringstream stream;
+    stream << file.rdbuf();
+    file.close();
+
+    std::filesystem::remove(filePath);
+    return stream.str();
+}
+
+TEST(General, PathWriter)
+{
+    PathWriter invalid("/non/existent/directory/file.kml", PathWriter::Format::Kml);
+    EXPECT_FALSE(invalid);
+
+    const auto kml = writePaths(PathWriter::Format::Kml, false, 1 << 20);
+    EXPECT_EQ(kml.find("<kml xmlns="), 39);
+    EXPECT_NE(kml.find("<name>Route 2</name>"), std::string::npos);
+    EXPECT_NE(kml.find("0.5,-1.25,0\n1,-2.5,0\n"), std::string::npos);
+    EXPECT_EQ(kml.substr(kml.size() - 6), "</kml>");
+
+    // Small buffers written by the background thread produce the same output.
+    EXPECT_EQ(writePaths(PathWriter::Format::Kml, true, 16), kml);
+
+    const auto json = writePaths(PathWriter::Format::GeoJson, false, 1 << 20);
+    EXPECT_EQ(json,
+              "{\"type\":\"FeatureCollection\",\"features\":[\n"
+              "{\"type\":\"Feature\",\"properties\":{\"name\":\"Route 0\"},"
+              "\"geometry\":{\"type\":\"LineString\",\"coordinates\":[[0.5,-1.25],[1,-2.5]]}},\n"
+              "{\"type\":\"Feature\",\"properties\":{\"name\":\"Route 1\"},"
+              "\"geometry\":{\"type\":\"LineString\",\"coordinates\":[[0.5,-1.25],[1,-2.5]]}},\n"
+              "{\"type\":\"Feature\",\"properties\":{\"name\":\"Route 2\"},"
+              "\"geometry\":{\"type\":\"LineString\",\"coordinates\":[[0.5,-1.25],[1,-2.5]]}}"
+              "\n]}\n");
+    EXPECT_EQ(writePaths(PathWriter::Format::GeoJson, true, 16), json);
+}
 
 int main(int argc, char**argv)
 {